@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <cstring>
+#include "custom_memory.h"
+#include "benchmark_common.h"
+
+// A mixed-size workload: every record is an odd-sized header followed by a payload
+// of doubles. With the plain arena_push the payloads land wherever the headers left
+// the stack pointer, so a good chunk of them straddle cache lines. With the aligned
+// push every payload sits on its natural boundary.
+//
+// The payload is shaped like a 256-bit SIMD vector. Both variants go through
+// memcpy to touch it so the unaligned variant stays well-defined; the compiler
+// turns those into plain loads and stores, so the only difference measured is
+// where the payload sits in memory.
+
+struct alignas(32) payload_t
+{
+    double values[4];
+};
+
+// Run once with a working set that fits in cache, where split loads are the cost
+// that shows up, and once with one that doesn't, where padding costs bandwidth.
+static const size_t record_counts[] = { 1 << 12, 1 << 20 };
+static const size_t total_accesses = 1 << 24;
+static size_t record_count = 0;
+static size_t access_passes = 0;
+
+static payload_t**
+build_records(memory_arena_t *arena, payload_t **table, bool aligned, uint64_t *elapsed)
+{
+
+    benchmark_random_t random = { 0x9E3779B97F4A7C15ULL };
+
+    uint64_t start = get_wall_clock_ns();
+    for (size_t i = 0; i < record_count; i++)
+    {
+        size_t header_size = 1 + (benchmark_random_next(&random) % 15);
+        char* header = (char*)arena_push(arena, header_size);
+        header[0] = (char)header_size;
+
+        payload_t* payload = (aligned)
+            ? arena_push_struct(arena, payload_t)
+            : (payload_t*)arena_push(arena, sizeof(payload_t));
+        payload_t value = {};
+        for (int j = 0; j < 4; j++)
+            value.values[j] = (double)(i + j);
+        memcpy((void*)payload, &value, sizeof(payload_t));
+        table[i] = payload;
+    }
+    *elapsed = get_wall_clock_ns() - start;
+
+    return table;
+
+}
+
+static double
+sweep_records(payload_t **table, uint64_t *elapsed)
+{
+
+    double sum = 0.0;
+    uint64_t start = get_wall_clock_ns();
+    for (size_t pass = 0; pass < access_passes; pass++)
+    {
+        for (size_t i = 0; i < record_count; i++)
+        {
+            payload_t value;
+            memcpy(&value, (void*)table[i], sizeof(payload_t));
+            sum += value.values[0] + value.values[1]
+                + value.values[2] + value.values[3];
+            value.values[pass & 3] += 1.0;
+            memcpy((void*)table[i], &value, sizeof(payload_t));
+        }
+    }
+    *elapsed = get_wall_clock_ns() - start;
+
+    return sum;
+
+}
+
+static size_t
+count_split_records(payload_t **table)
+{
+    size_t split_count = 0;
+    for (size_t i = 0; i < record_count; i++)
+    {
+        size_t first = ((size_t)table[i]) / 64;
+        size_t last = (((size_t)table[i]) + sizeof(payload_t) - 1) / 64;
+        if (first != last) split_count++;
+    }
+    return split_count;
+}
+
+int
+main(int argc, char** argv)
+{
+
+    memory_arena_t records_arena;
+    memory_arena_t table_arena;
+    reserve_arena(&records_arena, 256 * 1024 * 1024);
+    allocate_arena(&table_arena, sizeof(payload_t*) * record_counts[1]);
+
+    payload_t** table = arena_push_array(&table_arena, payload_t*, record_counts[1]);
+
+    for (size_t size_index = 0; size_index < 2; size_index++)
+    {
+
+        record_count = record_counts[size_index];
+        access_passes = total_accesses / record_count;
+        printf("Mixed-size workload: %zu records, %zu sweeps\n\n", record_count, access_passes);
+
+        for (int variant = 0; variant < 2; variant++)
+        {
+
+            bool aligned = (variant == 1);
+            uint64_t build_elapsed = 0;
+            uint64_t sweep_elapsed = 0;
+
+            // Build once untimed so the page commits and faults aren't part of the push.
+            arena_reset(&records_arena);
+            build_records(&records_arena, table, aligned, &build_elapsed);
+            arena_reset(&records_arena);
+            build_records(&records_arena, table, aligned, &build_elapsed);
+            double sum = sweep_records(table, &sweep_elapsed);
+            benchmark_do_not_optimize(&sum);
+
+            printf("%s (%zu of %zu payloads split a cache line, %zu bytes used)\n",
+                    (aligned) ? "arena_push_struct (aligned)" : "arena_push (unaligned)",
+                    count_split_records(table), record_count, records_arena.commit);
+            benchmark_print_result("    push", build_elapsed, record_count);
+            benchmark_print_result("    sweep", sweep_elapsed, record_count * access_passes);
+
+        }
+
+        printf("\n");
+
+    }
+
+    release_arena(&table_arena);
+    release_arena(&records_arena);
+
+    return 0;
+
+}
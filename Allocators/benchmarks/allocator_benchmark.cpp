@@ -0,0 +1,230 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+#include "custom_memory.h"
+#include "arena_resource.h"
+#include "benchmark_common.h"
+
+// The allocator benchmark suite. Every allocator is run through the same matrix of
+// allocation sizes, free patterns and thread counts, and we report nanoseconds per
+// allocate/free pair along with peak resident memory and page faults for the run.
+//
+// Each thread owns its own allocator instance (except malloc and new/delete, which are
+// process-wide by nature). A round allocates a batch, touches every block, and then
+// frees the batch in one of these orders:
+//
+//  - LIFO:   newest first, the stack allocator's home turf.
+//  - FIFO:   oldest first, a queue.
+//  - Random: shuffled, the general allocator case.
+//  - Frame:  nothing is freed individually; the whole batch goes at once at the end
+//            of the round. Allocators without a bulk reset free everything in order.
+//
+// Usage: allocator_benchmark [max threads]
+
+static const size_t batch_size = 4096;
+static const size_t rounds = 64;
+static const size_t allocation_sizes[] = { 16, 64, 256, 4096 };
+static const size_t arena_reserve_size = (size_t)1024 * 1024 * 1024;
+
+enum free_pattern
+{
+    PATTERN_LIFO,
+    PATTERN_FIFO,
+    PATTERN_RANDOM,
+    PATTERN_FRAME,
+    PATTERN_COUNT,
+};
+
+static const char* pattern_names[] = { "lifo", "fifo", "random", "frame" };
+
+// Allocator adapters. Every one of them exposes the same three calls so the pattern
+// code can be written once.
+
+struct malloc_adapter
+{
+    static const char* name() { return "malloc/free"; }
+    void* allocate(size_t size) { return malloc(size); }
+    void deallocate(void* pointer, size_t) { free(pointer); }
+    bool end_round() { return false; }
+};
+
+struct new_delete_adapter
+{
+    static const char* name() { return "new/delete"; }
+    void* allocate(size_t size) { return new char[size]; }
+    void deallocate(void* pointer, size_t) { delete[] (char*)pointer; }
+    bool end_round() { return false; }
+};
+
+struct arena_adapter
+{
+    arena_adapter() { reserve_arena(&arena, arena_reserve_size); }
+    ~arena_adapter() { release_arena(&arena); }
+
+    static const char* name() { return "memory_arena_t"; }
+    void* allocate(size_t size) { return arena_push_aligned(&arena, size, 16); }
+    void deallocate(void* pointer, size_t size) { arena_deallocate_if_top(&arena, pointer, size); }
+    bool end_round() { arena_reset(&arena); return true; }
+
+    memory_arena_t arena;
+};
+
+struct monotonic_adapter
+{
+    monotonic_adapter() : resource(std::pmr::new_delete_resource()) { }
+
+    static const char* name() { return "pmr::monotonic_buffer"; }
+    void* allocate(size_t size) { return resource.allocate(size, 16); }
+    void deallocate(void* pointer, size_t size) { resource.deallocate(pointer, size, 16); }
+    bool end_round() { resource.release(); return true; }
+
+    std::pmr::monotonic_buffer_resource resource;
+};
+
+struct pool_resource_adapter
+{
+    pool_resource_adapter() : resource(std::pmr::new_delete_resource()) { }
+
+    static const char* name() { return "pmr::unsynchronized_pool"; }
+    void* allocate(size_t size) { return resource.allocate(size, 16); }
+    void deallocate(void* pointer, size_t size) { resource.deallocate(pointer, size, 16); }
+    bool end_round() { return false; }
+
+    std::pmr::unsynchronized_pool_resource resource;
+};
+
+template <typename Adapter> static void
+run_thread(free_pattern pattern, size_t size, size_t thread_index)
+{
+
+    Adapter adapter;
+    benchmark_random_t random = { 0x9E3779B97F4A7C15ULL ^ (thread_index + 1) };
+    std::vector<void*> blocks(batch_size);
+    std::vector<size_t> order(batch_size);
+
+    for (size_t round = 0; round < rounds; round++)
+    {
+
+        for (size_t i = 0; i < batch_size; i++)
+        {
+            char* block = (char*)adapter.allocate(size);
+            block[0] = (char)i;
+            block[size - 1] = (char)round;
+            blocks[i] = block;
+        }
+
+        switch (pattern)
+        {
+            case PATTERN_LIFO:
+            {
+                for (size_t i = batch_size; i > 0; i--)
+                    adapter.deallocate(blocks[i - 1], size);
+            } break;
+
+            case PATTERN_FIFO:
+            {
+                for (size_t i = 0; i < batch_size; i++)
+                    adapter.deallocate(blocks[i], size);
+            } break;
+
+            case PATTERN_RANDOM:
+            {
+                for (size_t i = 0; i < batch_size; i++)
+                    order[i] = i;
+                for (size_t i = batch_size - 1; i > 0; i--)
+                {
+                    size_t j = benchmark_random_next(&random) % (i + 1);
+                    size_t swap = order[i]; order[i] = order[j]; order[j] = swap;
+                }
+                for (size_t i = 0; i < batch_size; i++)
+                    adapter.deallocate(blocks[order[i]], size);
+            } break;
+
+            default: break;
+        }
+
+        // Frame pattern frees one by one only when the allocator can't drop everything
+        // at once.
+        bool has_reset = adapter.end_round();
+        if (pattern == PATTERN_FRAME && !has_reset)
+        {
+            for (size_t i = 0; i < batch_size; i++)
+                adapter.deallocate(blocks[i], size);
+        }
+
+    }
+
+}
+
+template <typename Adapter> static void
+run_configuration(free_pattern pattern, size_t size, size_t thread_count)
+{
+
+    benchmark_reset_peak_rss();
+    benchmark_process_stats_t before = benchmark_get_process_stats();
+
+    uint64_t start = get_wall_clock_ns();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; t++)
+        threads.emplace_back(run_thread<Adapter>, pattern, size, t);
+    for (std::thread& thread : threads)
+        thread.join();
+    uint64_t elapsed = get_wall_clock_ns() - start;
+
+    benchmark_process_stats_t after = benchmark_get_process_stats();
+
+    size_t operations = batch_size * rounds * thread_count;
+    printf("%-26s %6zu %-7s %3zu %10.2f %12.1f %10zu %8zu\n",
+            Adapter::name(), size, pattern_names[pattern], thread_count,
+            (double)elapsed / (double)operations,
+            (double)after.peak_rss / (1024.0 * 1024.0),
+            after.minor_faults - before.minor_faults,
+            after.major_faults - before.major_faults);
+
+}
+
+template <typename Adapter> static void
+run_allocator(size_t max_threads)
+{
+
+    for (size_t size_index = 0; size_index < sizeof(allocation_sizes) / sizeof(size_t); size_index++)
+    {
+        for (int pattern = 0; pattern < PATTERN_COUNT; pattern++)
+        {
+            for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+                run_configuration<Adapter>((free_pattern)pattern,
+                        allocation_sizes[size_index], thread_count);
+        }
+    }
+
+    printf("\n");
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > 8) max_threads = 8;
+    if (argc > 1) max_threads = (size_t)atoi(argv[1]);
+
+    printf("%zu allocations per round, %zu rounds per thread\n", batch_size, rounds);
+    printf("ns/op is per allocate/free pair; peak RSS is for the whole process.\n\n");
+    printf("%-26s %6s %-7s %3s %10s %12s %10s %8s\n",
+            "allocator", "size", "pattern", "thr", "ns/op", "peak RSS MB",
+            "min faults", "maj flt");
+
+    run_allocator<malloc_adapter>(max_threads);
+    run_allocator<new_delete_adapter>(max_threads);
+    run_allocator<arena_adapter>(max_threads);
+    run_allocator<monotonic_adapter>(max_threads);
+    run_allocator<pool_resource_adapter>(max_threads);
+
+    return 0;
+
+}
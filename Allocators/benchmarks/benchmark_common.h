@@ -0,0 +1,121 @@
+#ifndef CUSTOM_ALLOCATORS_BENCHMARK_COMMON_H
+#define CUSTOM_ALLOCATORS_BENCHMARK_COMMON_H
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#   include <psapi.h>
+#elif defined(__linux__)
+#   include <sys/resource.h>
+#endif
+
+// Small helpers shared by the benchmark executables. Nothing fancy; a wall clock,
+// a cheap deterministic random number generator so runs are reproducible, and a
+// sink that keeps the optimizer from throwing our work away.
+
+inline uint64_t
+get_wall_clock_ns()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+struct benchmark_random_t
+{
+    uint64_t state;
+};
+
+inline uint64_t
+benchmark_random_next(benchmark_random_t *random)
+{
+    // xorshift64*, good enough to shuffle sizes and indices.
+    uint64_t x = random->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    random->state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+inline void
+benchmark_do_not_optimize(void* pointer)
+{
+#   if defined(_MSC_VER)
+        static void* volatile sink;
+        sink = pointer;
+#   else
+        asm volatile("" : : "r"(pointer) : "memory");
+#   endif
+}
+
+inline void
+benchmark_print_result(const char* name, uint64_t elapsed_ns, uint64_t operations)
+{
+    double ns_per_op = (double)elapsed_ns / (double)operations;
+    double ops_per_sec = (double)operations / ((double)elapsed_ns / 1e9);
+    printf("%-40s %10.2f ns/op %14.0f ops/s\n", name, ns_per_op, ops_per_sec);
+}
+
+// Process-wide memory statistics. Peak RSS is the high-water mark of resident memory
+// since the last benchmark_reset_peak_rss(); page faults are cumulative, so take the
+// difference between two snapshots.
+struct benchmark_process_stats_t
+{
+    size_t peak_rss;
+    size_t minor_faults;
+    size_t major_faults;
+};
+
+inline benchmark_process_stats_t
+benchmark_get_process_stats()
+{
+
+    benchmark_process_stats_t stats = {};
+
+#   if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters = {};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        stats.peak_rss = (size_t)counters.PeakWorkingSetSize;
+        stats.minor_faults = (size_t)counters.PageFaultCount;
+#   elif defined(__linux__)
+        // VmHWM can be reset through clear_refs, ru_maxrss can't, so prefer it.
+        FILE* status = fopen("/proc/self/status", "r");
+        if (status != NULL)
+        {
+            char line[256];
+            size_t kilobytes = 0;
+            while (fgets(line, sizeof(line), status) != NULL)
+            {
+                if (sscanf(line, "VmHWM: %zu kB", &kilobytes) == 1)
+                    stats.peak_rss = kilobytes * 1024;
+            }
+            fclose(status);
+        }
+
+        struct rusage usage = {};
+        getrusage(RUSAGE_SELF, &usage);
+        stats.minor_faults = (size_t)usage.ru_minflt;
+        stats.major_faults = (size_t)usage.ru_majflt;
+#   endif
+
+    return stats;
+
+}
+
+inline void
+benchmark_reset_peak_rss()
+{
+#   if defined(__linux__)
+        // Writing 5 to clear_refs resets the peak RSS counter (Linux 4.0+).
+        FILE* clear_refs = fopen("/proc/self/clear_refs", "w");
+        if (clear_refs != NULL)
+        {
+            fputs("5", clear_refs);
+            fclose(clear_refs);
+        }
+#   endif
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "custom_memory.h"
+#include "bulk_memory.h"
+#include "benchmark_common.h"
+
+// Throughput of arena_fill() and arena_copy() at every SIMD level the CPU supports,
+// against memset() and memcpy(), for block sizes from a cache line to well past the
+// last level cache. Each size moves roughly the same total number of bytes. Sizes at
+// or above ARENA_BULK_NONTEMPORAL_THRESHOLD use streaming stores.
+//
+// Usage: bulk_benchmark [total megabytes per size]
+
+static const char* level_names[] =
+{
+    "libc",
+    "sse2",
+    "avx2",
+    "avx512",
+};
+
+static const size_t block_sizes[] =
+{
+    64, 256, 1024, 4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024,
+    1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024,
+};
+
+static void
+print_throughput(const char* name, size_t block_size, uint64_t elapsed_ns, size_t total_bytes)
+{
+    char label[96];
+    snprintf(label, sizeof(label), "    %-8s %10zu bytes", name, block_size);
+    printf("%-40s %10.2f GB/s\n", label, (double)total_bytes / (double)elapsed_ns);
+}
+
+static void
+run_fill(const char* name, bool use_libc, char *buffer, size_t block_size, size_t total_bytes)
+{
+
+    size_t repetitions = total_bytes / block_size;
+    if (repetitions == 0) repetitions = 1;
+
+    uint64_t start = get_wall_clock_ns();
+    for (size_t i = 0; i < repetitions; i++)
+    {
+        if (use_libc)
+            memset(buffer, (int)i, block_size);
+        else
+            arena_fill(buffer, (int)i, block_size);
+        benchmark_do_not_optimize(buffer);
+    }
+    uint64_t elapsed = get_wall_clock_ns() - start;
+
+    print_throughput(name, block_size, elapsed, repetitions * block_size);
+
+}
+
+static void
+run_copy(const char* name, bool use_libc, char *destination, const char *source,
+        size_t block_size, size_t total_bytes)
+{
+
+    size_t repetitions = total_bytes / block_size;
+    if (repetitions == 0) repetitions = 1;
+
+    uint64_t start = get_wall_clock_ns();
+    for (size_t i = 0; i < repetitions; i++)
+    {
+        if (use_libc)
+            memcpy(destination, source, block_size);
+        else
+            arena_copy(destination, source, block_size);
+        benchmark_do_not_optimize(destination);
+    }
+    uint64_t elapsed = get_wall_clock_ns() - start;
+
+    print_throughput(name, block_size, elapsed, repetitions * block_size);
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t total_megabytes = 1024;
+    if (argc > 1) total_megabytes = (size_t)atoi(argv[1]);
+    size_t total_bytes = total_megabytes * 1024 * 1024;
+
+    size_t largest_block = block_sizes[sizeof(block_sizes) / sizeof(block_sizes[0]) - 1];
+    memory_arena_t arena;
+    if (!allocate_arena(&arena, 2 * largest_block + 4096))
+    {
+        printf("unable to allocate the benchmark arena\n");
+        return 1;
+    }
+
+    char* source = (char*)arena_push_zeroed(&arena, largest_block, 64);
+    char* destination = (char*)arena_push_zeroed(&arena, largest_block, 64);
+    memset(source, 0x5A, largest_block);
+    memset(destination, 0, largest_block);
+
+    arena_simd_level supported = arena_simd_supported();
+    printf("%zu MB per size, best supported level: %s\n\n", total_megabytes,
+            level_names[supported]);
+
+    printf("fill\n");
+    for (size_t block_size : block_sizes)
+    {
+        run_fill("memset", true, destination, block_size, total_bytes);
+        for (int level = ARENA_SIMD_SSE2; level <= (int)supported; level++)
+        {
+            arena_simd_select((arena_simd_level)level);
+            run_fill(level_names[level], false, destination, block_size, total_bytes);
+        }
+    }
+
+    printf("\ncopy\n");
+    for (size_t block_size : block_sizes)
+    {
+        run_copy("memcpy", true, destination, source, block_size, total_bytes);
+        for (int level = ARENA_SIMD_SSE2; level <= (int)supported; level++)
+        {
+            arena_simd_select((arena_simd_level)level);
+            run_copy(level_names[level], false, destination, source, block_size, total_bytes);
+        }
+    }
+
+    release_arena(&arena);
+    return 0;
+
+}
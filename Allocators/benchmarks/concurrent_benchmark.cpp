@@ -0,0 +1,185 @@
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "custom_memory.h"
+#include "concurrent_memory.h"
+#include "benchmark_common.h"
+
+// Scaling benchmark for multi-threaded bump allocation. Every thread performs the same
+// number of small allocations and touches each one. We compare:
+//
+//  - malloc/free, the general purpose baseline.
+//  - A plain memory_arena_t behind a std::mutex.
+//  - The concurrent arena without per-thread caching (one fetch_add per push).
+//  - The concurrent arena with per-thread chunk caches.
+//
+// The arena variants reset once every thread has finished a round, which is how they
+// would be used in practice; malloc frees each round's allocations instead.
+
+static const size_t allocations_per_round = 1 << 14;
+static const size_t rounds = 32;
+static const size_t arena_size = 512 * 1024 * 1024;
+
+enum allocator_kind
+{
+    ALLOCATOR_MALLOC,
+    ALLOCATOR_MUTEX_ARENA,
+    ALLOCATOR_SHARED_COUNTER,
+    ALLOCATOR_CACHED_CONCURRENT,
+};
+
+static const char* allocator_names[] =
+{
+    "malloc/free",
+    "mutex arena",
+    "concurrent arena (shared counter)",
+    "concurrent arena (chunk cache)",
+};
+
+struct benchmark_state_t
+{
+    memory_arena_t mutex_arena;
+    std::mutex mutex_arena_lock;
+    concurrent_arena_t concurrent_arena;
+};
+
+static size_t
+random_allocation_size(benchmark_random_t *random)
+{
+    return 8 + (benchmark_random_next(random) % 120);
+}
+
+static void
+run_worker_round(benchmark_state_t *state, allocator_kind kind, size_t thread_index,
+        concurrent_arena_cache_t *cache, void **pointers)
+{
+
+    benchmark_random_t random = { 0x9E3779B97F4A7C15ULL ^ (thread_index + 1) };
+
+    for (size_t i = 0; i < allocations_per_round; i++)
+    {
+        size_t size = random_allocation_size(&random);
+        char* block = NULL;
+
+        switch (kind)
+        {
+            case ALLOCATOR_MALLOC:
+            {
+                block = (char*)malloc(size);
+            } break;
+
+            case ALLOCATOR_MUTEX_ARENA:
+            {
+                std::lock_guard<std::mutex> guard(state->mutex_arena_lock);
+                block = (char*)arena_push_aligned(&state->mutex_arena, size, 16);
+            } break;
+
+            case ALLOCATOR_SHARED_COUNTER:
+            {
+                block = (char*)concurrent_arena_push_shared(&state->concurrent_arena, size, 16);
+            } break;
+
+            case ALLOCATOR_CACHED_CONCURRENT:
+            {
+                block = (char*)concurrent_arena_push(cache, size, 16);
+            } break;
+        }
+
+        if (block == NULL)
+        {
+            printf("Allocation failed; arena too small for this run.\n");
+            exit(1);
+        }
+
+        block[0] = (char)i;
+        pointers[i] = block;
+    }
+
+    if (kind == ALLOCATOR_MALLOC)
+    {
+        for (size_t i = 0; i < allocations_per_round; i++)
+            free(pointers[i]);
+    }
+
+}
+
+static uint64_t
+run_benchmark(benchmark_state_t *state, allocator_kind kind, size_t thread_count)
+{
+
+    uint64_t elapsed = 0;
+    for (size_t round = 0; round < rounds; round++)
+    {
+
+        arena_reset(&state->mutex_arena);
+        concurrent_arena_reset(&state->concurrent_arena);
+
+        std::vector<std::thread> threads;
+        std::vector<std::vector<void*>> pointers(thread_count,
+                std::vector<void*>(allocations_per_round));
+
+        uint64_t start = get_wall_clock_ns();
+        for (size_t t = 0; t < thread_count; t++)
+        {
+            threads.emplace_back([state, kind, t, &pointers]()
+            {
+                concurrent_arena_cache_t cache;
+                concurrent_arena_cache_initialize(&cache, &state->concurrent_arena);
+                run_worker_round(state, kind, t, &cache, pointers[t].data());
+            });
+        }
+
+        for (std::thread& thread : threads)
+            thread.join();
+        elapsed += get_wall_clock_ns() - start;
+
+    }
+
+    return elapsed;
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 4) max_threads = 4;
+    if (argc > 1) max_threads = (size_t)atoi(argv[1]);
+
+    benchmark_state_t* state = new benchmark_state_t();
+    if (!allocate_arena(&state->mutex_arena, arena_size)
+            || !allocate_concurrent_arena(&state->concurrent_arena, arena_size))
+    {
+        printf("Unable to allocate benchmark arenas.\n");
+        return 1;
+    }
+
+    printf("%zu allocations of 8-128 bytes per thread per round, %zu rounds\n\n",
+            allocations_per_round, rounds);
+
+    for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+
+        printf("%zu thread(s)\n", thread_count);
+        for (int kind = 0; kind < 4; kind++)
+        {
+            uint64_t elapsed = run_benchmark(state, (allocator_kind)kind, thread_count);
+            char label[64];
+            snprintf(label, sizeof(label), "    %s", allocator_names[kind]);
+            benchmark_print_result(label, elapsed,
+                    allocations_per_round * rounds * thread_count);
+        }
+        printf("\n");
+
+    }
+
+    release_concurrent_arena(&state->concurrent_arena);
+    release_arena(&state->mutex_arena);
+    delete state;
+
+    return 0;
+
+}
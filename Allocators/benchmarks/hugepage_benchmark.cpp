@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <cstdlib>
+#include "custom_memory.h"
+#include "benchmark_common.h"
+
+#if defined(__linux__)
+#   include <sys/mman.h>
+#endif
+
+// Random access over a large arena-resident table, with and without huge pages. With
+// 4KB pages a multi-GB table needs far more TLB entries than the CPU has, so nearly
+// every random access pays for a page walk on top of the cache miss. Two access
+// patterns are measured:
+//
+//  - Independent random reads, where the CPU can overlap many misses.
+//  - A dependent pointer chase through a single random cycle, where it can't.
+//
+// Usage: hugepage_benchmark [table size in MB]
+
+static const char* backing_names[] =
+{
+    "standard pages",
+    "explicit huge pages",
+    "transparent huge pages",
+};
+
+static const size_t access_count = 1 << 24;
+
+static void
+fill_chase_cycle(uint64_t *table, size_t entry_count)
+{
+
+    // Sattolo's algorithm gives us one cycle through every entry.
+    for (size_t i = 0; i < entry_count; i++)
+        table[i] = i;
+
+    benchmark_random_t random = { 0xD1B54A32D192ED03ULL };
+    for (size_t i = entry_count - 1; i > 0; i--)
+    {
+        size_t j = benchmark_random_next(&random) % i;
+        uint64_t swap = table[i];
+        table[i] = table[j];
+        table[j] = swap;
+    }
+
+}
+
+static void
+run_configuration(const char* name, arena_page_size page_size, size_t table_size)
+{
+
+    memory_arena_t arena;
+    if (!allocate_arena(&arena, table_size, page_size))
+    {
+        printf("%s: unable to allocate %zu bytes\n", name, table_size);
+        return;
+    }
+
+    // Keep the baseline honest; with THP set to "always" the kernel would otherwise
+    // hand out huge pages for the standard configuration too.
+#   if defined(__linux__)
+        if (page_size == ARENA_PAGES_DEFAULT)
+            madvise(arena.memory_region, arena.capacity, MADV_NOHUGEPAGE);
+#   endif
+
+    size_t entry_count = table_size / sizeof(uint64_t);
+    uint64_t* table = arena_push_array(&arena, uint64_t, entry_count);
+
+    uint64_t start = get_wall_clock_ns();
+    fill_chase_cycle(table, entry_count);
+    uint64_t fill_elapsed = get_wall_clock_ns() - start;
+
+    printf("%s\n", name);
+    printf("    granted: %s, %zu byte pages, %zu of %zu bytes on huge pages\n",
+            backing_names[arena.page_backing], arena.page_size,
+            arena_huge_page_bytes(&arena), arena.capacity);
+    benchmark_print_result("    fill + shuffle", fill_elapsed, entry_count);
+
+    // Independent reads.
+    benchmark_random_t random = { 0x9E3779B97F4A7C15ULL };
+    uint64_t sum = 0;
+    start = get_wall_clock_ns();
+    for (size_t i = 0; i < access_count; i++)
+        sum += table[benchmark_random_next(&random) % entry_count];
+    benchmark_print_result("    random reads", get_wall_clock_ns() - start, access_count);
+    benchmark_do_not_optimize(&sum);
+
+    // Dependent chase.
+    uint64_t index = 0;
+    start = get_wall_clock_ns();
+    for (size_t i = 0; i < access_count; i++)
+        index = table[index];
+    benchmark_print_result("    pointer chase", get_wall_clock_ns() - start, access_count);
+    benchmark_do_not_optimize(&index);
+
+    printf("\n");
+    release_arena(&arena);
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t table_megabytes = 1024;
+    if (argc > 1) table_megabytes = (size_t)atoi(argv[1]);
+    size_t table_size = table_megabytes * 1024 * 1024;
+
+    printf("Table: %zu MB, %zu accesses per pattern\n\n", table_megabytes, access_count);
+
+    run_configuration("ARENA_PAGES_DEFAULT", ARENA_PAGES_DEFAULT, table_size);
+    run_configuration("ARENA_PAGES_HUGE_2MB", ARENA_PAGES_HUGE_2MB, table_size);
+    run_configuration("ARENA_PAGES_HUGE_1GB", ARENA_PAGES_HUGE_1GB, table_size);
+
+    return 0;
+
+}
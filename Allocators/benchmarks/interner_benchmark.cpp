@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "custom_memory.h"
+#include "string_interner.h"
+#include "benchmark_common.h"
+
+// Interning identifiers with string_interner_t against std::unordered_set<std::string>.
+// The identifiers look like the ones a compiler or asset pipeline sees: a handful of
+// prefixes, a number, between 6 and 40 bytes long. Each is fed in twice (in shuffled
+// order) so half the inserts find the string already there. After that, every
+// identifier is looked up again (hits), and as many identifiers that were never added
+// (misses). Query strings are built up front so neither side pays for constructing them.
+//
+// Usage: interner_benchmark [identifier count]
+
+static const char* prefixes[] =
+{
+    "x", "node_", "texture/environment/", "get_", "CMakeFiles/allocators.dir/source/",
+    "m_", "shader_variant_", "tmp",
+};
+
+static std::vector<std::string>
+make_identifiers(size_t count, uint64_t seed)
+{
+
+    std::vector<std::string> identifiers;
+    identifiers.reserve(count);
+    benchmark_random_t random = { seed };
+    char buffer[96];
+    for (size_t i = 0; i < count; i++)
+    {
+        const char* prefix = prefixes[benchmark_random_next(&random) % 8];
+        snprintf(buffer, sizeof(buffer), "%s%zu_%llx", prefix, i,
+                (unsigned long long)(seed & 0xFFFF));
+        identifiers.push_back(buffer);
+    }
+
+    return identifiers;
+
+}
+
+static void
+shuffle(std::vector<const std::string*> &list, uint64_t seed)
+{
+
+    if (list.size() < 2)
+        return;
+
+    benchmark_random_t random = { seed };
+    for (size_t i = list.size() - 1; i > 0; i--)
+    {
+        size_t j = (size_t)(benchmark_random_next(&random) % (i + 1));
+        const std::string* swap = list[i];
+        list[i] = list[j];
+        list[j] = swap;
+    }
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t identifier_count = 2000000;
+    if (argc > 1) identifier_count = (size_t)atoi(argv[1]);
+
+    std::vector<std::string> identifiers = make_identifiers(identifier_count, 0x1234);
+    std::vector<std::string> missing = make_identifiers(identifier_count, 0x5678);
+
+    std::vector<const std::string*> inserts;
+    inserts.reserve(identifier_count * 2);
+    for (const std::string& identifier : identifiers)
+    {
+        inserts.push_back(&identifier);
+        inserts.push_back(&identifier);
+    }
+    shuffle(inserts, 0x9ABC);
+
+    std::vector<const std::string*> hits;
+    hits.reserve(identifier_count);
+    for (const std::string& identifier : identifiers)
+        hits.push_back(&identifier);
+    shuffle(hits, 0xDEF0);
+
+    printf("%zu identifiers, %zu inserts\n\n", identifier_count, inserts.size());
+
+    // std::unordered_set
+    {
+        std::unordered_set<std::string> set;
+        uint64_t start = get_wall_clock_ns();
+        for (const std::string* identifier : inserts)
+            set.insert(*identifier);
+        benchmark_print_result("unordered_set insert", get_wall_clock_ns() - start,
+                inserts.size());
+
+        size_t found = 0;
+        start = get_wall_clock_ns();
+        for (const std::string* identifier : hits)
+            found += set.find(*identifier) != set.end();
+        benchmark_print_result("unordered_set lookup (hit)", get_wall_clock_ns() - start,
+                hits.size());
+
+        start = get_wall_clock_ns();
+        for (const std::string& identifier : missing)
+            found += set.find(identifier) != set.end();
+        benchmark_print_result("unordered_set lookup (miss)", get_wall_clock_ns() - start,
+                missing.size());
+
+        if (found != identifier_count || set.size() != identifier_count)
+            printf("unordered_set gave the wrong answer\n");
+    }
+
+    printf("\n");
+
+    // string_interner_t
+    {
+        string_interner_t interner;
+        if (!allocate_string_interner(&interner))
+        {
+            printf("unable to allocate the interner\n");
+            return 1;
+        }
+
+        uint64_t start = get_wall_clock_ns();
+        for (const std::string* identifier : inserts)
+            string_intern(&interner, identifier->data(), identifier->size());
+        benchmark_print_result("string_intern", get_wall_clock_ns() - start, inserts.size());
+
+        size_t found = 0;
+        start = get_wall_clock_ns();
+        for (const std::string* identifier : hits)
+            found += string_interner_find(&interner, identifier->data(), identifier->size())
+                != INTERNED_STRING_NONE;
+        benchmark_print_result("string_interner_find (hit)", get_wall_clock_ns() - start,
+                hits.size());
+
+        start = get_wall_clock_ns();
+        for (const std::string& identifier : missing)
+            found += string_interner_find(&interner, identifier.data(), identifier.size())
+                != INTERNED_STRING_NONE;
+        benchmark_print_result("string_interner_find (miss)", get_wall_clock_ns() - start,
+                missing.size());
+
+        if (found != identifier_count || interner.count != identifier_count)
+            printf("string_interner_t gave the wrong answer\n");
+
+        printf("%-40s %10.2f MB strings, %.2f MB table\n", "interner memory",
+                (double)interner.strings.commit / (1024.0 * 1024.0),
+                (double)interner.table_arena.commit / (1024.0 * 1024.0));
+        release_string_interner(&interner);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,223 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include "custom_memory.h"
+#include "persistent_memory.h"
+#include "benchmark_common.h"
+
+#if defined(_WIN32)
+#   define unlink _unlink
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+// Startup cost of a large lookup structure: building it from scratch versus mapping the
+// copy a previous run left in a persistent arena. The structure is a chained hash table
+// of 64 byte records, linked with offset_ptr so it works wherever the file is mapped.
+//
+// The benchmark builds the table into a persistent arena, closes it, then reopens the
+// file and measures the time until the first lookup succeeds, and the cost of a batch of
+// random lookups afterwards (which includes faulting the pages in). The reopen happens
+// in the same process, so the file is still in the page cache; drop caches between two
+// runs with --keep to measure a cold start from disk. The file lives in the system's
+// temp directory, not wherever the benchmark happens to be launched from.
+//
+// Usage: persistent_benchmark [dataset megabytes] [--keep]
+
+#define DATASET_VERSION 1
+
+static const size_t lookup_count = 1 << 20;
+
+struct record_t
+{
+    uint64_t key;
+    uint64_t values[6];
+    offset_ptr<record_t> next;
+};
+
+struct dataset_t
+{
+    uint64_t bucket_count;
+    uint64_t record_count;
+    uint64_t seed;
+    offset_ptr<offset_ptr<record_t>> buckets;
+};
+
+static uint64_t
+hash_key(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return key;
+}
+
+// Keys are a bijection of the record index, so lookups can pick any record at random.
+static uint64_t
+record_key(const dataset_t *dataset, uint64_t index)
+{
+    return hash_key(index ^ dataset->seed);
+}
+
+// Stands in for whatever parsing and processing the real service does on startup.
+static dataset_t*
+build_dataset(memory_arena_t *arena, size_t record_count)
+{
+
+    dataset_t* dataset = arena_push_struct(arena, dataset_t);
+    dataset->bucket_count = 1;
+    while (dataset->bucket_count < record_count)
+        dataset->bucket_count <<= 1;
+    dataset->record_count = record_count;
+    dataset->seed = 0x9E3779B97F4A7C15ULL;
+
+    offset_ptr<record_t>* buckets = arena_push_array(arena, offset_ptr<record_t>,
+            dataset->bucket_count);
+    memset((void*)buckets, 0, sizeof(offset_ptr<record_t>) * dataset->bucket_count);
+    dataset->buckets = buckets;
+
+    for (size_t i = 0; i < record_count; i++)
+    {
+        record_t* record = arena_push_struct(arena, record_t);
+        record->key = record_key(dataset, i);
+        for (size_t j = 0; j < 6; j++)
+            record->values[j] = record->key * (j + 1);
+
+        offset_ptr<record_t>* bucket = &buckets[hash_key(record->key) & (dataset->bucket_count - 1)];
+        record->next = *bucket;
+        *bucket = record;
+    }
+
+    return dataset;
+
+}
+
+static record_t*
+find_record(dataset_t *dataset, uint64_t key)
+{
+    record_t* record = dataset->buckets[hash_key(key) & (dataset->bucket_count - 1)].get();
+    while (record != NULL && record->key != key)
+        record = record->next.get();
+    return record;
+}
+
+// Looks up keys of records picked at random, so the lookups land all over the file.
+static uint64_t
+run_lookups(dataset_t *dataset, size_t count)
+{
+
+    uint64_t checksum = 0;
+    benchmark_random_t random = { 0xD1B54A32D192ED03ULL };
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t index = benchmark_random_next(&random) % dataset->record_count;
+        record_t* record = find_record(dataset, record_key(dataset, index));
+        checksum += (record != NULL) ? record->values[4] : 0;
+    }
+
+    return checksum;
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t dataset_megabytes = 512;
+    bool keep = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--keep") == 0) keep = true;
+        else dataset_megabytes = (size_t)atoi(argv[i]);
+    }
+
+    std::error_code temp_error;
+    std::filesystem::path temp_directory = std::filesystem::temp_directory_path(temp_error);
+    if (temp_error)
+    {
+        printf("no temp directory: %s\n", temp_error.message().c_str());
+        return 1;
+    }
+    std::string dataset_path = (temp_directory / "persistent_benchmark.arena").string();
+
+    size_t record_count = dataset_megabytes * 1024 * 1024 / (sizeof(record_t) + 2 * 8);
+    size_t reserve_size = dataset_megabytes * 1024 * 1024 * 2;
+    printf("%zu records (%zu byte records), %zu MB reserved\n\n", record_count,
+            sizeof(record_t), reserve_size / (1024 * 1024));
+
+    // First run: a file from an earlier --keep run is reused; otherwise, build it. The
+    // file is only a cache, so one left by a run with a bigger dataset is thrown away.
+    persistent_arena_t persistent;
+    uint64_t start = get_wall_clock_ns();
+    persistent_arena_status status = open_persistent_arena(&persistent, dataset_path.c_str(),
+            reserve_size, DATASET_VERSION, true);
+    if (status == PERSISTENT_ARENA_FAILED)
+    {
+        printf("unable to open %s\n", dataset_path.c_str());
+        return 1;
+    }
+
+    dataset_t* dataset = persistent_arena_get_root<dataset_t>(&persistent);
+    if (status == PERSISTENT_ARENA_CREATED || dataset == NULL
+            || dataset->record_count != record_count)
+    {
+        if (persistent.rejected_reason != NULL)
+            printf("existing file rejected: %s\n", persistent.rejected_reason);
+
+        arena_reset(&persistent.arena);
+        dataset = build_dataset(&persistent.arena, record_count);
+        persistent_arena_set_root(&persistent, dataset);
+        printf("%-40s %10.2f ms\n", "build from scratch",
+                (double)(get_wall_clock_ns() - start) / 1e6);
+    }
+    else
+    {
+        printf("%-40s %10.2f ms\n", "reused file from an earlier run",
+                (double)(get_wall_clock_ns() - start) / 1e6);
+    }
+
+    uint64_t expected = run_lookups(dataset, lookup_count);
+
+    start = get_wall_clock_ns();
+    close_persistent_arena(&persistent);
+    printf("%-40s %10.2f ms\n", "close (write back to disk)",
+            (double)(get_wall_clock_ns() - start) / 1e6);
+
+    // Second run: map the file and go.
+    start = get_wall_clock_ns();
+    status = open_persistent_arena(&persistent, dataset_path.c_str(), reserve_size,
+            DATASET_VERSION);
+    dataset = persistent_arena_get_root<dataset_t>(&persistent);
+    if (status != PERSISTENT_ARENA_OPENED || dataset == NULL)
+    {
+        printf("reopening failed: %s\n", persistent.rejected_reason ? persistent.rejected_reason
+                : "no root");
+        return 1;
+    }
+
+    record_t* first = find_record(dataset, record_key(dataset, 0));
+    uint64_t ready = get_wall_clock_ns() - start;
+    printf("%-40s %10.2f ms\n", "reopen until first lookup", (double)ready / 1e6);
+    benchmark_do_not_optimize(first);
+    if (first == NULL)
+    {
+        printf("first record missing after reopen\n");
+        return 1;
+    }
+
+    start = get_wall_clock_ns();
+    uint64_t checksum = run_lookups(dataset, lookup_count);
+    benchmark_print_result("random lookups after reopen", get_wall_clock_ns() - start,
+            lookup_count);
+    printf("lookups %s\n", (checksum == expected) ? "match" : "DO NOT MATCH");
+
+    close_persistent_arena(&persistent);
+    if (!keep)
+        unlink(dataset_path.c_str());
+
+    return 0;
+
+}
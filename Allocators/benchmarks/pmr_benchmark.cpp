@@ -0,0 +1,192 @@
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "custom_memory.h"
+#include "arena_resource.h"
+#include "benchmark_common.h"
+
+// Container-heavy workloads run against three memory resources:
+//
+//  - The default resource (new/delete).
+//  - std::pmr::monotonic_buffer_resource over new/delete.
+//  - arena_memory_resource over a reserved memory_arena_t.
+//
+// Each iteration builds its containers from scratch and throws them away, the way a
+// request handler or a per-frame parser would. The monotonic resource is released and
+// the arena is rewound between iterations.
+
+static const size_t iterations = 64;
+static const size_t word_count = 1 << 15;
+
+static std::string
+generate_document(size_t words)
+{
+
+    benchmark_random_t random = { 0x2545F4914F6CDD1DULL };
+    std::string document;
+
+    // A small vocabulary so the map sees repeats, with lengths that straddle the
+    // small string optimization.
+    for (size_t i = 0; i < words; i++)
+    {
+        size_t word_id = benchmark_random_next(&random) % 4096;
+        size_t length = 4 + (word_id % 24);
+        for (size_t j = 0; j < length; j++)
+            document.push_back((char)('a' + ((word_id * 31 + j * 7) % 26)));
+        document.push_back((i % 16 == 15) ? '\n' : ' ');
+    }
+
+    return document;
+
+}
+
+// Splits the document into lines of words.
+static size_t
+parse_document(const std::string& document, std::pmr::memory_resource *resource)
+{
+
+    std::pmr::vector<std::pmr::vector<std::pmr::string>> lines(resource);
+    std::pmr::vector<std::pmr::string> line(resource);
+    std::pmr::string word(resource);
+
+    for (char c : document)
+    {
+        if (c == ' ' || c == '\n')
+        {
+            line.push_back(word);
+            word.clear();
+            if (c == '\n')
+            {
+                lines.push_back(std::move(line));
+                line = std::pmr::vector<std::pmr::string>(resource);
+            }
+        }
+        else
+        {
+            word.push_back(c);
+        }
+    }
+
+    return lines.size();
+
+}
+
+// Counts words into a map keyed by string.
+static size_t
+count_words(const std::string& document, std::pmr::memory_resource *resource)
+{
+
+    std::pmr::unordered_map<std::pmr::string, int> counts(resource);
+    std::pmr::string word(resource);
+
+    for (char c : document)
+    {
+        if (c == ' ' || c == '\n')
+        {
+            counts[word]++;
+            word.clear();
+        }
+        else
+        {
+            word.push_back(c);
+        }
+    }
+
+    return counts.size();
+
+}
+
+// Grows a bunch of vectors one element at a time.
+static size_t
+grow_vectors(const std::string& document, std::pmr::memory_resource *resource)
+{
+
+    std::pmr::vector<std::pmr::vector<size_t>> buckets(resource);
+    for (size_t i = 0; i < 64; i++)
+        buckets.emplace_back();
+
+    for (size_t i = 0; i < document.size(); i++)
+        buckets[(unsigned char)document[i] % 64].push_back(i);
+
+    return buckets[0].size();
+
+}
+
+typedef size_t (*workload_fptr)(const std::string&, std::pmr::memory_resource*);
+
+static void
+run_workload(const char* name, workload_fptr workload, const std::string& document,
+        memory_arena_t *arena)
+{
+
+    printf("%s\n", name);
+
+    // Default resource.
+    {
+        size_t sink = 0;
+        uint64_t start = get_wall_clock_ns();
+        for (size_t i = 0; i < iterations; i++)
+            sink += workload(document, std::pmr::new_delete_resource());
+        benchmark_print_result("    new/delete", get_wall_clock_ns() - start, iterations);
+        benchmark_do_not_optimize(&sink);
+    }
+
+    // Monotonic buffer resource.
+    {
+        size_t sink = 0;
+        uint64_t start = get_wall_clock_ns();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            std::pmr::monotonic_buffer_resource monotonic(std::pmr::new_delete_resource());
+            sink += workload(document, &monotonic);
+        }
+        benchmark_print_result("    monotonic_buffer_resource", get_wall_clock_ns() - start,
+                iterations);
+        benchmark_do_not_optimize(&sink);
+    }
+
+    // Arena resource.
+    {
+        size_t sink = 0;
+        arena_memory_resource resource(arena);
+        uint64_t start = get_wall_clock_ns();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            arena_scope_t scope(arena);
+            sink += workload(document, &resource);
+        }
+        benchmark_print_result("    arena_memory_resource", get_wall_clock_ns() - start,
+                iterations);
+        printf("    (arena committed: %zu bytes)\n", arena->capacity);
+        benchmark_do_not_optimize(&sink);
+    }
+
+    printf("\n");
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    memory_arena_t arena;
+    if (!reserve_arena(&arena, (size_t)1024 * 1024 * 1024))
+    {
+        printf("Unable to reserve benchmark arena.\n");
+        return 1;
+    }
+
+    std::string document = generate_document(word_count);
+    printf("Document: %zu words, %zu bytes, %zu iterations per workload (ns/op is per iteration)\n\n",
+            word_count, document.size(), iterations);
+
+    run_workload("Parse into vectors of strings", parse_document, document, &arena);
+    run_workload("Build word count map", count_words, document, &arena);
+    run_workload("Grow vectors element by element", grow_vectors, document, &arena);
+
+    release_arena(&arena);
+    return 0;
+
+}
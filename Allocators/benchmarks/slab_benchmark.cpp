@@ -0,0 +1,172 @@
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "custom_memory.h"
+#include "ring_memory.h"
+#include "slab_allocator.h"
+#include "benchmark_common.h"
+
+// Small-object churn across threads, slab allocator against malloc()/free(). Two
+// patterns:
+//
+//  - Local churn: every thread allocates and frees its own objects, keeping a window
+//    of live objects and replacing a random one each step.
+//  - Producer/consumer: threads are paired up; the producer allocates objects and
+//    hands them to its consumer through a ring buffer, and the consumer frees them. All
+//    of the frees happen on a different thread than the allocations, which is the case
+//    thread caches have to work hardest for.
+//
+// Usage: slab_benchmark [maximum thread pairs]
+
+static const size_t objects_per_thread = 1 << 21;
+static const size_t live_window = 4096;
+
+struct allocator_adapter_t
+{
+    const char* name;
+    void* (*allocate)(size_t size);
+    void (*release)(void* pointer);
+};
+
+static void* malloc_allocate(size_t size) { return malloc(size); }
+static void malloc_release(void* pointer) { free(pointer); }
+
+static const allocator_adapter_t adapters[] =
+{
+    { "malloc/free", malloc_allocate, malloc_release },
+    { "slab", slab_malloc, slab_free },
+};
+
+static size_t
+random_object_size(benchmark_random_t *random)
+{
+    return 8 + (benchmark_random_next(random) % 504);
+}
+
+static void
+run_local_churn(const allocator_adapter_t *adapter, size_t thread_index)
+{
+
+    benchmark_random_t random = { 0x9E3779B97F4A7C15ULL ^ (thread_index + 1) };
+    std::vector<void*> live(live_window, NULL);
+
+    for (size_t i = 0; i < objects_per_thread; i++)
+    {
+        size_t slot = (size_t)(benchmark_random_next(&random) % live_window);
+        adapter->release(live[slot]);
+        live[slot] = adapter->allocate(random_object_size(&random));
+        *(char*)live[slot] = (char)i;
+    }
+
+    for (size_t i = 0; i < live_window; i++)
+        adapter->release(live[i]);
+
+}
+
+static void
+run_producer(const allocator_adapter_t *adapter, ring_buffer_t *ring, size_t thread_index)
+{
+
+    benchmark_random_t random = { 0xD1B54A32D192ED03ULL ^ (thread_index + 1) };
+    for (size_t i = 0; i < objects_per_thread; i++)
+    {
+        void* object = adapter->allocate(random_object_size(&random));
+        *(char*)object = (char)i;
+        while (!ring_buffer_push(ring, &object, sizeof(object)))
+            std::this_thread::yield();
+    }
+
+}
+
+static void
+run_consumer(const allocator_adapter_t *adapter, ring_buffer_t *ring)
+{
+
+    size_t consumed = 0;
+    while (consumed < objects_per_thread)
+    {
+        size_t available = 0;
+        void** objects = (void**)ring_buffer_peek(ring, &available);
+        if (objects == NULL)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        size_t count = available / sizeof(void*);
+        for (size_t i = 0; i < count; i++)
+            adapter->release(objects[i]);
+
+        ring_buffer_consume(ring, count * sizeof(void*));
+        consumed += count;
+    }
+
+}
+
+static void
+run_pattern(const allocator_adapter_t *adapter, size_t pairs, bool producer_consumer)
+{
+
+    std::vector<ring_buffer_t> rings(pairs);
+    std::vector<std::thread> threads;
+
+    if (producer_consumer)
+    {
+        for (size_t i = 0; i < pairs; i++)
+            allocate_ring_buffer(&rings[i], 64 * 1024);
+    }
+
+    uint64_t start = get_wall_clock_ns();
+    for (size_t i = 0; i < pairs; i++)
+    {
+        if (producer_consumer)
+        {
+            threads.emplace_back(run_producer, adapter, &rings[i], i);
+            threads.emplace_back(run_consumer, adapter, &rings[i]);
+        }
+        else
+        {
+            threads.emplace_back(run_local_churn, adapter, 2 * i);
+            threads.emplace_back(run_local_churn, adapter, 2 * i + 1);
+        }
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+    uint64_t elapsed = get_wall_clock_ns() - start;
+
+    char name[128];
+    snprintf(name, sizeof(name), "    %-12s %zu threads", adapter->name, 2 * pairs);
+    benchmark_print_result(name, elapsed, 2 * pairs * objects_per_thread);
+
+    if (producer_consumer)
+    {
+        for (size_t i = 0; i < pairs; i++)
+            release_ring_buffer(&rings[i]);
+    }
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t maximum_pairs = 4;
+    if (argc > 1) maximum_pairs = (size_t)atoi(argv[1]);
+
+    printf("%zu objects per thread, 8 - 512 bytes\n\n", objects_per_thread);
+
+    printf("local churn\n");
+    for (size_t pairs = 1; pairs <= maximum_pairs; pairs *= 2)
+        for (const allocator_adapter_t& adapter : adapters)
+            run_pattern(&adapter, pairs, false);
+
+    printf("\nproducer/consumer\n");
+    for (size_t pairs = 1; pairs <= maximum_pairs; pairs *= 2)
+        for (const allocator_adapter_t& adapter : adapters)
+            run_pattern(&adapter, pairs, true);
+
+    return 0;
+
+}
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "custom_memory.h"
+#include "tlsf_allocator.h"
+#include "benchmark_common.h"
+
+// Latency distribution of the TLSF allocator against malloc()/free(). Averages hide the
+// thing we care about here, so every operation is timed on its own and we report the
+// percentiles and the single worst case.
+//
+// The workload keeps a table of live slots. Each step picks a random slot and frees it
+// if it is in use, or allocates into it otherwise, with sizes drawn log-uniformly from
+// 16 bytes to 128KB. Both allocators see the exact same sequence, and each gets a warm up
+// pass first so first-touch page faults don't dominate the tail.
+//
+// Usage: tlsf_benchmark [operation count]
+
+static const size_t slot_count = 1 << 14;
+static const size_t pool_size = 512 * 1024 * 1024;
+
+struct tlsf_adapter_t
+{
+    tlsf_allocator_t* allocator;
+    void* allocate(size_t size) { return tlsf_alloc(allocator, size); }
+    void release(void* pointer) { tlsf_free(allocator, pointer); }
+};
+
+struct malloc_adapter_t
+{
+    void* allocate(size_t size) { return malloc(size); }
+    void release(void* pointer) { free(pointer); }
+};
+
+static size_t
+random_size(benchmark_random_t *random)
+{
+    // 2^4 .. 2^16, log-uniform, then a random offset inside that power of two.
+    uint64_t bits = benchmark_random_next(random);
+    size_t shift = 4 + (size_t)(bits % 13);
+    size_t size = (size_t)1 << shift;
+    return size + (size_t)((bits >> 8) & (size - 1));
+}
+
+template <typename adapter_t> static void
+run_workload(adapter_t *adapter, void **slots, size_t operation_count,
+        std::vector<uint32_t> *alloc_ns, std::vector<uint32_t> *free_ns)
+{
+
+    benchmark_random_t random = { 0x2545F4914F6CDD1DULL };
+    for (size_t i = 0; i < operation_count; i++)
+    {
+        size_t slot = (size_t)(benchmark_random_next(&random) % slot_count);
+        if (slots[slot] != NULL)
+        {
+            uint64_t start = get_wall_clock_ns();
+            adapter->release(slots[slot]);
+            uint64_t elapsed = get_wall_clock_ns() - start;
+            if (free_ns) free_ns->push_back((uint32_t)elapsed);
+            slots[slot] = NULL;
+        }
+        else
+        {
+            size_t size = random_size(&random);
+            uint64_t start = get_wall_clock_ns();
+            void* pointer = adapter->allocate(size);
+            uint64_t elapsed = get_wall_clock_ns() - start;
+            if (alloc_ns) alloc_ns->push_back((uint32_t)elapsed);
+            if (pointer == NULL)
+            {
+                printf("allocation of %zu bytes failed\n", size);
+                exit(1);
+            }
+            *(char*)pointer = (char)i;
+            slots[slot] = pointer;
+        }
+    }
+
+}
+
+template <typename adapter_t> static void
+release_all(adapter_t *adapter, void **slots)
+{
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (slots[i] != NULL) adapter->release(slots[i]);
+        slots[i] = NULL;
+    }
+}
+
+static void
+print_latency(const char* name, std::vector<uint32_t> *samples)
+{
+
+    if (samples->empty())
+        return;
+
+    std::sort(samples->begin(), samples->end());
+    size_t count = samples->size();
+    uint64_t total = 0;
+    for (uint32_t sample : *samples)
+        total += sample;
+
+    printf("%-24s %8.1f mean %6u p50 %6u p99 %6u p99.9 %6u p99.99 %8u max (ns)\n", name,
+            (double)total / (double)count, (*samples)[count / 2], (*samples)[count * 99 / 100],
+            (*samples)[count * 999 / 1000], (*samples)[count * 9999 / 10000], samples->back());
+
+}
+
+template <typename adapter_t> static void
+run_allocator(const char* name, adapter_t *adapter, size_t operation_count)
+{
+
+    std::vector<void*> slots(slot_count, NULL);
+    std::vector<uint32_t> alloc_ns;
+    std::vector<uint32_t> free_ns;
+    alloc_ns.reserve(operation_count);
+    free_ns.reserve(operation_count);
+
+    run_workload(adapter, slots.data(), operation_count, NULL, NULL);
+    release_all(adapter, slots.data());
+    run_workload(adapter, slots.data(), operation_count, &alloc_ns, &free_ns);
+
+    printf("%s\n", name);
+    print_latency("    allocate", &alloc_ns);
+    print_latency("    free", &free_ns);
+
+    release_all(adapter, slots.data());
+
+}
+
+int
+main(int argc, char** argv)
+{
+
+    size_t operation_count = 1 << 21;
+    if (argc > 1) operation_count = (size_t)atoll(argv[1]);
+
+    printf("%zu operations over %zu slots, sizes 16B - 128KB\n\n", operation_count, slot_count);
+
+    memory_arena_t arena;
+    if (!reserve_arena(&arena, pool_size + 1024 * 1024))
+    {
+        printf("unable to reserve the TLSF arena\n");
+        return 1;
+    }
+
+    tlsf_allocator_t allocator;
+    tlsf_initialize(&allocator, &arena, pool_size);
+    tlsf_adapter_t tlsf_adapter = { &allocator };
+    run_allocator("tlsf", &tlsf_adapter, operation_count);
+
+    // Fragmentation only means something with a live set, so run one more pass and look
+    // at what it leaves behind.
+    std::vector<void*> slots(slot_count, NULL);
+    run_workload(&tlsf_adapter, slots.data(), operation_count, NULL, NULL);
+    tlsf_statistics_t statistics;
+    tlsf_get_statistics(&allocator, &statistics);
+    printf("    %zu live allocations, %zu used / %zu free bytes in %zu free blocks, "
+            "largest free %zu, fragmentation %.2f%%\n\n", statistics.allocation_count,
+            statistics.used_bytes, statistics.free_bytes, statistics.free_block_count,
+            statistics.largest_free_block, statistics.fragmentation * 100.0);
+    release_all(&tlsf_adapter, slots.data());
+
+    malloc_adapter_t malloc_adapter;
+    run_allocator("malloc", &malloc_adapter, operation_count);
+
+    release_arena(&arena);
+    return 0;
+
+}
@@ -0,0 +1,108 @@
+#ifndef CUSTOM_ALLOCATORS_ARENA_RESOURCE_H
+#define CUSTOM_ALLOCATORS_ARENA_RESOURCE_H
+#include <memory_resource>
+#include <new>
+#include "custom_memory.h"
+
+// Bridges between memory_arena_t and the standard library, so containers can allocate
+// from an arena without the rest of the code caring. Two flavors:
+//
+//  - arena_memory_resource, a std::pmr::memory_resource for std::pmr containers.
+//  - arena_allocator<T>, a classic Allocator for containers with an allocator parameter.
+//
+// Neither owns the arena. Deallocation is a no-op unless the block being freed is the
+// last thing pushed onto the arena, in which case it is popped; a vector that grows and
+// is then destroyed (or a string that is built and thrown away) gives its memory back.
+// Everything else is reclaimed when the arena is rewound.
+
+// Pops the block if it happens to be on top of the arena.
+inline void
+arena_deallocate_if_top(memory_arena_t *arena, void *pointer, size_t size)
+{
+    char* top = ((char*)arena->memory_region) + arena->commit;
+    if (((char*)pointer) + size == top)
+    {
+        arena->commit = (size_t)(((char*)pointer) - ((char*)arena->memory_region));
+        ARENA_RECORD_POP(arena);
+        arena_check_purge(arena);
+    }
+}
+
+class arena_memory_resource : public std::pmr::memory_resource
+{
+
+    public:
+        explicit arena_memory_resource(memory_arena_t *arena) : arena(arena) { }
+
+        memory_arena_t* get_arena() const { return arena; }
+
+    protected:
+        void*
+        do_allocate(size_t bytes, size_t alignment) override
+        {
+            void* result = arena_push_aligned(arena, bytes, alignment);
+            if (result == NULL)
+                throw std::bad_alloc();
+            return result;
+        }
+
+        void
+        do_deallocate(void* pointer, size_t bytes, size_t) override
+        {
+            arena_deallocate_if_top(arena, pointer, bytes);
+        }
+
+        bool
+        do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    private:
+        memory_arena_t* arena;
+
+};
+
+template <typename T>
+struct arena_allocator
+{
+
+    typedef T value_type;
+
+    explicit arena_allocator(memory_arena_t *arena) : arena(arena) { }
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) : arena(other.arena) { }
+
+    T*
+    allocate(size_t count)
+    {
+        T* result = arena_push_type_array<T>(arena, count);
+        if (result == NULL)
+            throw std::bad_alloc();
+        return result;
+    }
+
+    void
+    deallocate(T* pointer, size_t count)
+    {
+        arena_deallocate_if_top(arena, pointer, sizeof(T) * count);
+    }
+
+    memory_arena_t* arena;
+
+};
+
+template <typename T, typename U> inline bool
+operator==(const arena_allocator<T>& left, const arena_allocator<U>& right)
+{
+    return left.arena == right.arena;
+}
+
+template <typename T, typename U> inline bool
+operator!=(const arena_allocator<T>& left, const arena_allocator<U>& right)
+{
+    return left.arena != right.arena;
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include <cstring>
+#include "custom_memory.h"
+
+#if ARENA_INSTRUMENTATION
+
+static inline size_t
+get_histogram_bucket(size_t size)
+{
+
+    // Bucket n holds sizes in [2^n, 2^(n+1)), with zero-sized pushes in bucket zero.
+    size_t bucket = 0;
+    while (size > 1 && bucket < ARENA_HISTOGRAM_BUCKETS - 1)
+    {
+        size >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+
+}
+
+void
+arena_statistics_reset(memory_arena_t *arena)
+{
+    arena->statistics = {};
+}
+
+void
+arena_statistics_record_push(memory_arena_t *arena, size_t size, bool succeeded)
+{
+
+    arena_statistics_t* statistics = &arena->statistics;
+    if (!succeeded)
+    {
+        statistics->failed_push_count++;
+        return;
+    }
+
+    statistics->push_count++;
+    statistics->push_bytes += size;
+    statistics->size_histogram[get_histogram_bucket(size)]++;
+    if (arena->commit > statistics->peak_commit)
+        statistics->peak_commit = arena->commit;
+
+}
+
+void
+arena_statistics_record_pop(memory_arena_t *arena)
+{
+    arena->statistics.pop_count++;
+}
+
+void
+arena_statistics_record_call_site(memory_arena_t *arena, size_t size, const char* file, int line)
+{
+
+    arena_statistics_t* statistics = &arena->statistics;
+
+    // The same file name can show up at different addresses from different translation
+    // units, so we probe by line and compare the names themselves.
+    size_t hash = (size_t)line * 2654435761u;
+    for (size_t probe = 0; probe < ARENA_CALL_SITE_SLOTS; probe++)
+    {
+        arena_call_site_t* site = &statistics->call_sites[(hash + probe) % ARENA_CALL_SITE_SLOTS];
+        if (site->file == NULL)
+        {
+            site->file = file;
+            site->line = line;
+        }
+
+        if (site->line == line && (site->file == file || strcmp(site->file, file) == 0))
+        {
+            site->push_count++;
+            site->push_bytes += size;
+            return;
+        }
+    }
+
+    statistics->dropped_call_sites++;
+
+}
+
+void
+arena_statistics_report(memory_arena_t *arena, const char* name, FILE* output)
+{
+
+    arena_statistics_t* statistics = &arena->statistics;
+
+    fprintf(output, "Arena \"%s\"\n", name);
+    fprintf(output, "    commit: %zu / capacity: %zu / reserved: %zu bytes\n",
+            arena->commit, arena->capacity, arena->reserved);
+    fprintf(output, "    peak: %zu bytes (%.1f%% of reserved)\n", statistics->peak_commit,
+            (arena->reserved > 0) ? 100.0 * statistics->peak_commit / arena->reserved : 0.0);
+    fprintf(output, "    pushes: %zu (%zu bytes), pops: %zu, failed pushes: %zu\n",
+            statistics->push_count, statistics->push_bytes, statistics->pop_count,
+            statistics->failed_push_count);
+
+    fprintf(output, "    push sizes:\n");
+    for (size_t bucket = 0; bucket < ARENA_HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (statistics->size_histogram[bucket] == 0)
+            continue;
+        fprintf(output, "        %12zu+ bytes: %zu\n", (bucket == 0) ? 0 : ((size_t)1 << bucket),
+                statistics->size_histogram[bucket]);
+    }
+
+    bool printed_header = false;
+    for (size_t i = 0; i < ARENA_CALL_SITE_SLOTS; i++)
+    {
+        arena_call_site_t* site = &statistics->call_sites[i];
+        if (site->file == NULL)
+            continue;
+        if (!printed_header)
+        {
+            fprintf(output, "    call sites:\n");
+            printed_header = true;
+        }
+        fprintf(output, "        %s:%d: %zu pushes, %zu bytes\n", site->file, site->line,
+                site->push_count, site->push_bytes);
+    }
+
+    if (statistics->dropped_call_sites > 0)
+        fprintf(output, "        (%zu pushes from untracked call sites)\n",
+                statistics->dropped_call_sites);
+
+}
+
+#else
+
+// Instrumentation is compiled out; keep the symbols around so callers don't need to
+// wrap their report calls in the same preprocessor check.
+
+void arena_statistics_reset(memory_arena_t *) { }
+void arena_statistics_record_push(memory_arena_t *, size_t, bool) { }
+void arena_statistics_record_pop(memory_arena_t *) { }
+void arena_statistics_record_call_site(memory_arena_t *, size_t, const char*, int) { }
+
+void
+arena_statistics_report(memory_arena_t *, const char* name, FILE* output)
+{
+    fprintf(output, "Arena \"%s\": instrumentation disabled (build with ARENA_INSTRUMENTATION=1)\n",
+            name);
+}
+
+#endif
+
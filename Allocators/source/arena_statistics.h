@@ -0,0 +1,69 @@
+#ifndef CUSTOM_ALLOCATORS_ARENA_STATISTICS_H
+#define CUSTOM_ALLOCATORS_ARENA_STATISTICS_H
+#include <cstddef>
+#include <cstdio>
+
+// Optional instrumentation for memory_arena_t. Everything here is compiled out unless
+// ARENA_INSTRUMENTATION is defined to 1, in which case every arena carries a block of
+// statistics: peak usage, push/pop counts, a power-of-two histogram of push sizes, and
+// (with ARENA_INSTRUMENTATION_CALL_SITES also defined to 1) which file and line each
+// push came from. With it off, the record macros expand to nothing and pushes are
+// exactly the pointer bump they always were.
+//
+// CMake exposes both switches as the ALLOCATORS_INSTRUMENTATION and
+// ALLOCATORS_INSTRUMENTATION_CALL_SITES options.
+
+#ifndef ARENA_INSTRUMENTATION
+#   define ARENA_INSTRUMENTATION 0
+#endif
+
+#ifndef ARENA_INSTRUMENTATION_CALL_SITES
+#   define ARENA_INSTRUMENTATION_CALL_SITES 0
+#endif
+
+#define ARENA_HISTOGRAM_BUCKETS 48
+#define ARENA_CALL_SITE_SLOTS 64
+
+struct memory_arena_t;
+
+struct arena_call_site_t
+{
+    const char* file;
+    int line;
+    size_t push_count;
+    size_t push_bytes;
+};
+
+struct arena_statistics_t
+{
+    size_t peak_commit;
+    size_t push_count;
+    size_t push_bytes;
+    size_t pop_count;
+    size_t failed_push_count;
+    size_t size_histogram[ARENA_HISTOGRAM_BUCKETS];
+
+    // A small open-addressed table; call sites past the last slot are only counted.
+    arena_call_site_t call_sites[ARENA_CALL_SITE_SLOTS];
+    size_t dropped_call_sites;
+};
+
+void   arena_statistics_reset(memory_arena_t *arena);
+void   arena_statistics_record_push(memory_arena_t *arena, size_t size, bool succeeded);
+void   arena_statistics_record_pop(memory_arena_t *arena);
+void   arena_statistics_record_call_site(memory_arena_t *arena, size_t size,
+            const char* file, int line);
+void   arena_statistics_report(memory_arena_t *arena, const char* name, FILE* output);
+
+#if ARENA_INSTRUMENTATION
+#   define ARENA_RECORD_RESET(arena) arena_statistics_reset(arena)
+#   define ARENA_RECORD_PUSH(arena, size, succeeded) \
+        arena_statistics_record_push(arena, size, succeeded)
+#   define ARENA_RECORD_POP(arena) arena_statistics_record_pop(arena)
+#else
+#   define ARENA_RECORD_RESET(arena)
+#   define ARENA_RECORD_PUSH(arena, size, succeeded)
+#   define ARENA_RECORD_POP(arena)
+#endif
+
+#endif
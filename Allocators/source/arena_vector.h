@@ -0,0 +1,111 @@
+#ifndef CUSTOM_ALLOCATORS_ARENA_VECTOR_H
+#define CUSTOM_ALLOCATORS_ARENA_VECTOR_H
+#include <type_traits>
+#include "custom_memory.h"
+
+// A growable array that lives on an arena and grows with arena_realloc. As long as it
+// is the last thing pushed onto its arena, growing just moves the top of the stack and
+// never copies; once something else has been pushed after it, the next growth copies
+// it to the top and it is back on the fast path from then on. The memory it leaves
+// behind is reclaimed when the arena is rewound.
+//
+// Elements are moved with memcpy, so T must be trivially copyable. The vector never
+// frees anything, so it needs no destructor and can itself live on an arena.
+
+template <typename T>
+struct arena_vector
+{
+
+    static_assert(std::is_trivially_copyable<T>::value,
+            "arena_vector elements are relocated with memcpy.");
+
+    memory_arena_t* arena;
+    T* data;
+    size_t count;
+    size_t capacity;
+
+    explicit arena_vector(memory_arena_t *arena)
+        : arena(arena), data(NULL), count(0), capacity(0) { }
+
+    // Returns false if the arena has run out of space; the vector is left unchanged.
+    bool
+    reserve(size_t new_capacity)
+    {
+
+        if (new_capacity <= capacity)
+            return true;
+        if (new_capacity > (size_t)-1 / sizeof(T))
+            return false;
+
+        T* result = (T*)arena_realloc(arena, data, sizeof(T) * capacity,
+                sizeof(T) * new_capacity, alignof(T));
+        if (result == NULL)
+            return false;
+
+        data = result;
+        capacity = new_capacity;
+        return true;
+
+    }
+
+    bool
+    push_back(const T& value)
+    {
+
+        if (count == capacity && !reserve((capacity < 8) ? 8 : capacity * 2))
+            return false;
+
+        data[count++] = value;
+        return true;
+
+    }
+
+    // Appends extra uninitialized elements and returns the first of them, or NULL.
+    T*
+    push_many(size_t extra)
+    {
+
+        if (extra > capacity - count)
+        {
+            size_t required = count + extra;
+            if (required < count)
+                return NULL;
+            size_t grown = (capacity * 2 > required) ? capacity * 2 : required;
+            if (!reserve(grown) && !reserve(required))
+                return NULL;
+        }
+
+        T* result = data + count;
+        count += extra;
+        return result;
+
+    }
+
+    void pop_back() { assert(count > 0); count--; }
+    void clear() { count = 0; }
+
+    // Hands the unused tail back to the arena, if the vector is still on top.
+    void
+    shrink_to_fit()
+    {
+        if (data == NULL)
+            return;
+        data = (T*)arena_realloc(arena, data, sizeof(T) * capacity, sizeof(T) * count,
+                alignof(T));
+        capacity = count;
+    }
+
+    T& operator[](size_t index) { assert(index < count); return data[index]; }
+    const T& operator[](size_t index) const { assert(index < count); return data[index]; }
+
+    T* begin() { return data; }
+    T* end() { return data + count; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+};
+
+#endif
@@ -0,0 +1,457 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "bulk_memory.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   define ARENA_BULK_X64 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
+#else
+#   define ARENA_BULK_X64 0
+#endif
+
+// MSVC lets us use any intrinsic anywhere; GCC and Clang need each kernel marked with
+// the instruction set it is allowed to use.
+#if defined(_MSC_VER) && !defined(__clang__)
+#   define ARENA_BULK_TARGET(isa)
+#else
+#   define ARENA_BULK_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+typedef void (*arena_fill_kernel)(void *destination, int value, size_t size);
+typedef void (*arena_copy_kernel)(void *destination, const void *source, size_t size);
+
+static void
+fill_libc(void *destination, int value, size_t size)
+{
+    memset(destination, value, size);
+}
+
+static void
+copy_libc(void *destination, const void *source, size_t size)
+{
+    memcpy(destination, source, size);
+}
+
+#if ARENA_BULK_X64
+
+// Every kernel follows the same shape: blocks under two vectors go to the C library;
+// otherwise one unaligned store covers the head, aligned (or streaming) stores cover the
+// middle, and one unaligned store covers the tail. Head and tail may overlap the middle,
+// which is cheaper than handling the ragged edges a byte at a time. Copies load the head
+// and tail up front so overlapping stores never read bytes that were already written.
+
+ARENA_BULK_TARGET("sse2") static void
+fill_sse2(void *destination, int value, size_t size)
+{
+
+    if (size < 32)
+    {
+        memset(destination, value, size);
+        return;
+    }
+
+    char* start = (char*)destination;
+    char* end = start + size;
+    __m128i pattern = _mm_set1_epi8((char)value);
+    _mm_storeu_si128((__m128i*)start, pattern);
+
+    char* cursor = (char*)(((size_t)start + 16) & ~(size_t)15);
+    if (size >= ARENA_BULK_NONTEMPORAL_THRESHOLD)
+    {
+        for (; cursor + 16 <= end; cursor += 16)
+            _mm_stream_si128((__m128i*)cursor, pattern);
+        _mm_sfence();
+    }
+    else
+    {
+        for (; cursor + 64 <= end; cursor += 64)
+        {
+            _mm_store_si128((__m128i*)(cursor +  0), pattern);
+            _mm_store_si128((__m128i*)(cursor + 16), pattern);
+            _mm_store_si128((__m128i*)(cursor + 32), pattern);
+            _mm_store_si128((__m128i*)(cursor + 48), pattern);
+        }
+        for (; cursor + 16 <= end; cursor += 16)
+            _mm_store_si128((__m128i*)cursor, pattern);
+    }
+
+    _mm_storeu_si128((__m128i*)(end - 16), pattern);
+
+}
+
+ARENA_BULK_TARGET("sse2") static void
+copy_sse2(void *destination, const void *source, size_t size)
+{
+
+    if (size < 32)
+    {
+        memcpy(destination, source, size);
+        return;
+    }
+
+    char* target = (char*)destination;
+    const char* origin = (const char*)source;
+    __m128i head = _mm_loadu_si128((const __m128i*)origin);
+    __m128i tail = _mm_loadu_si128((const __m128i*)(origin + size - 16));
+
+    size_t offset = (16 - ((size_t)target & 15)) & 15;
+    if (size >= ARENA_BULK_NONTEMPORAL_THRESHOLD)
+    {
+        for (; offset + 16 <= size; offset += 16)
+            _mm_stream_si128((__m128i*)(target + offset),
+                    _mm_loadu_si128((const __m128i*)(origin + offset)));
+        _mm_sfence();
+    }
+    else
+    {
+        for (; offset + 64 <= size; offset += 64)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(origin + offset +  0));
+            __m128i b = _mm_loadu_si128((const __m128i*)(origin + offset + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(origin + offset + 32));
+            __m128i d = _mm_loadu_si128((const __m128i*)(origin + offset + 48));
+            _mm_store_si128((__m128i*)(target + offset +  0), a);
+            _mm_store_si128((__m128i*)(target + offset + 16), b);
+            _mm_store_si128((__m128i*)(target + offset + 32), c);
+            _mm_store_si128((__m128i*)(target + offset + 48), d);
+        }
+        for (; offset + 16 <= size; offset += 16)
+            _mm_store_si128((__m128i*)(target + offset),
+                    _mm_loadu_si128((const __m128i*)(origin + offset)));
+    }
+
+    _mm_storeu_si128((__m128i*)target, head);
+    _mm_storeu_si128((__m128i*)(target + size - 16), tail);
+
+}
+
+ARENA_BULK_TARGET("avx2") static void
+fill_avx2(void *destination, int value, size_t size)
+{
+
+    if (size < 64)
+    {
+        memset(destination, value, size);
+        return;
+    }
+
+    char* start = (char*)destination;
+    char* end = start + size;
+    __m256i pattern = _mm256_set1_epi8((char)value);
+    _mm256_storeu_si256((__m256i*)start, pattern);
+
+    char* cursor = (char*)(((size_t)start + 32) & ~(size_t)31);
+    if (size >= ARENA_BULK_NONTEMPORAL_THRESHOLD)
+    {
+        for (; cursor + 32 <= end; cursor += 32)
+            _mm256_stream_si256((__m256i*)cursor, pattern);
+        _mm_sfence();
+    }
+    else
+    {
+        for (; cursor + 128 <= end; cursor += 128)
+        {
+            _mm256_store_si256((__m256i*)(cursor +  0), pattern);
+            _mm256_store_si256((__m256i*)(cursor + 32), pattern);
+            _mm256_store_si256((__m256i*)(cursor + 64), pattern);
+            _mm256_store_si256((__m256i*)(cursor + 96), pattern);
+        }
+        for (; cursor + 32 <= end; cursor += 32)
+            _mm256_store_si256((__m256i*)cursor, pattern);
+    }
+
+    _mm256_storeu_si256((__m256i*)(end - 32), pattern);
+    _mm256_zeroupper();
+
+}
+
+ARENA_BULK_TARGET("avx2") static void
+copy_avx2(void *destination, const void *source, size_t size)
+{
+
+    if (size < 64)
+    {
+        memcpy(destination, source, size);
+        return;
+    }
+
+    char* target = (char*)destination;
+    const char* origin = (const char*)source;
+    __m256i head = _mm256_loadu_si256((const __m256i*)origin);
+    __m256i tail = _mm256_loadu_si256((const __m256i*)(origin + size - 32));
+
+    size_t offset = (32 - ((size_t)target & 31)) & 31;
+    if (size >= ARENA_BULK_NONTEMPORAL_THRESHOLD)
+    {
+        for (; offset + 32 <= size; offset += 32)
+            _mm256_stream_si256((__m256i*)(target + offset),
+                    _mm256_loadu_si256((const __m256i*)(origin + offset)));
+        _mm_sfence();
+    }
+    else
+    {
+        for (; offset + 128 <= size; offset += 128)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(origin + offset +  0));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(origin + offset + 32));
+            __m256i c = _mm256_loadu_si256((const __m256i*)(origin + offset + 64));
+            __m256i d = _mm256_loadu_si256((const __m256i*)(origin + offset + 96));
+            _mm256_store_si256((__m256i*)(target + offset +  0), a);
+            _mm256_store_si256((__m256i*)(target + offset + 32), b);
+            _mm256_store_si256((__m256i*)(target + offset + 64), c);
+            _mm256_store_si256((__m256i*)(target + offset + 96), d);
+        }
+        for (; offset + 32 <= size; offset += 32)
+            _mm256_store_si256((__m256i*)(target + offset),
+                    _mm256_loadu_si256((const __m256i*)(origin + offset)));
+    }
+
+    _mm256_storeu_si256((__m256i*)target, head);
+    _mm256_storeu_si256((__m256i*)(target + size - 32), tail);
+    _mm256_zeroupper();
+
+}
+
+ARENA_BULK_TARGET("avx512f") static void
+fill_avx512(void *destination, int value, size_t size)
+{
+
+    if (size < 128)
+    {
+        memset(destination, value, size);
+        return;
+    }
+
+    char* start = (char*)destination;
+    char* end = start + size;
+    __m512i pattern = _mm512_set1_epi32((int)((uint8_t)value * 0x01010101u));
+    _mm512_storeu_si512((void*)start, pattern);
+
+    char* cursor = (char*)(((size_t)start + 64) & ~(size_t)63);
+    if (size >= ARENA_BULK_NONTEMPORAL_THRESHOLD)
+    {
+        for (; cursor + 64 <= end; cursor += 64)
+            _mm512_stream_si512((__m512i*)cursor, pattern);
+        _mm_sfence();
+    }
+    else
+    {
+        for (; cursor + 256 <= end; cursor += 256)
+        {
+            _mm512_store_si512((void*)(cursor +   0), pattern);
+            _mm512_store_si512((void*)(cursor +  64), pattern);
+            _mm512_store_si512((void*)(cursor + 128), pattern);
+            _mm512_store_si512((void*)(cursor + 192), pattern);
+        }
+        for (; cursor + 64 <= end; cursor += 64)
+            _mm512_store_si512((void*)cursor, pattern);
+    }
+
+    _mm512_storeu_si512((void*)(end - 64), pattern);
+    _mm256_zeroupper();
+
+}
+
+ARENA_BULK_TARGET("avx512f") static void
+copy_avx512(void *destination, const void *source, size_t size)
+{
+
+    if (size < 128)
+    {
+        memcpy(destination, source, size);
+        return;
+    }
+
+    char* target = (char*)destination;
+    const char* origin = (const char*)source;
+    __m512i head = _mm512_loadu_si512((const void*)origin);
+    __m512i tail = _mm512_loadu_si512((const void*)(origin + size - 64));
+
+    size_t offset = (64 - ((size_t)target & 63)) & 63;
+    if (size >= ARENA_BULK_NONTEMPORAL_THRESHOLD)
+    {
+        for (; offset + 64 <= size; offset += 64)
+            _mm512_stream_si512((__m512i*)(target + offset),
+                    _mm512_loadu_si512((const void*)(origin + offset)));
+        _mm_sfence();
+    }
+    else
+    {
+        for (; offset + 256 <= size; offset += 256)
+        {
+            __m512i a = _mm512_loadu_si512((const void*)(origin + offset +   0));
+            __m512i b = _mm512_loadu_si512((const void*)(origin + offset +  64));
+            __m512i c = _mm512_loadu_si512((const void*)(origin + offset + 128));
+            __m512i d = _mm512_loadu_si512((const void*)(origin + offset + 192));
+            _mm512_store_si512((void*)(target + offset +   0), a);
+            _mm512_store_si512((void*)(target + offset +  64), b);
+            _mm512_store_si512((void*)(target + offset + 128), c);
+            _mm512_store_si512((void*)(target + offset + 192), d);
+        }
+        for (; offset + 64 <= size; offset += 64)
+            _mm512_store_si512((void*)(target + offset),
+                    _mm512_loadu_si512((const void*)(origin + offset)));
+    }
+
+    _mm512_storeu_si512((void*)target, head);
+    _mm512_storeu_si512((void*)(target + size - 64), tail);
+    _mm256_zeroupper();
+
+}
+
+#endif
+
+static arena_simd_level
+detect_simd_level()
+{
+
+#   if ARENA_BULK_X64 && defined(_MSC_VER)
+        // The CPU has to support the instructions and the OS has to save the registers.
+        int registers[4];
+        __cpuid(registers, 0);
+        int highest_leaf = registers[0];
+
+        __cpuid(registers, 1);
+        bool os_saves_ymm = false;
+        bool os_saves_zmm = false;
+        if (registers[2] & (1 << 27))
+        {
+            unsigned long long enabled = _xgetbv(0);
+            os_saves_ymm = (enabled & 0x06) == 0x06;
+            os_saves_zmm = (enabled & 0xE6) == 0xE6;
+        }
+
+        if (highest_leaf >= 7)
+        {
+            __cpuidex(registers, 7, 0);
+            if (os_saves_zmm && (registers[1] & (1 << 16)))
+                return ARENA_SIMD_AVX512;
+            if (os_saves_ymm && (registers[1] & (1 << 5)))
+                return ARENA_SIMD_AVX2;
+        }
+        return ARENA_SIMD_SSE2;
+#   elif ARENA_BULK_X64
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return ARENA_SIMD_AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return ARENA_SIMD_AVX2;
+        return ARENA_SIMD_SSE2;
+#   else
+        return ARENA_SIMD_LIBC;
+#   endif
+
+}
+
+static void fill_resolve(void *destination, int value, size_t size);
+static void copy_resolve(void *destination, const void *source, size_t size);
+
+// Both start out pointing at a resolver that picks the kernels on first use.
+static std::atomic<arena_fill_kernel> fill_kernel = { fill_resolve };
+static std::atomic<arena_copy_kernel> copy_kernel = { copy_resolve };
+static std::atomic<arena_simd_level> selected_level = { ARENA_SIMD_LIBC };
+
+arena_simd_level
+arena_simd_supported()
+{
+    static arena_simd_level supported = detect_simd_level();
+    return supported;
+}
+
+arena_simd_level
+arena_simd_selected()
+{
+    if (fill_kernel.load(std::memory_order_relaxed) == fill_resolve)
+        arena_simd_select(arena_simd_supported());
+    return selected_level.load(std::memory_order_relaxed);
+}
+
+// Levels the CPU can't run are clamped to the best one it can.
+void
+arena_simd_select(arena_simd_level level)
+{
+
+    if (level > arena_simd_supported())
+        level = arena_simd_supported();
+
+    arena_fill_kernel fill = fill_libc;
+    arena_copy_kernel copy = copy_libc;
+
+#   if ARENA_BULK_X64
+        switch (level)
+        {
+            case ARENA_SIMD_SSE2:   fill = fill_sse2;   copy = copy_sse2;   break;
+            case ARENA_SIMD_AVX2:   fill = fill_avx2;   copy = copy_avx2;   break;
+            case ARENA_SIMD_AVX512: fill = fill_avx512; copy = copy_avx512; break;
+            default: break;
+        }
+#   endif
+
+    selected_level.store(level, std::memory_order_relaxed);
+    fill_kernel.store(fill, std::memory_order_relaxed);
+    copy_kernel.store(copy, std::memory_order_relaxed);
+
+}
+
+static void
+fill_resolve(void *destination, int value, size_t size)
+{
+    arena_simd_select(arena_simd_supported());
+    fill_kernel.load(std::memory_order_relaxed)(destination, value, size);
+}
+
+static void
+copy_resolve(void *destination, const void *source, size_t size)
+{
+    arena_simd_select(arena_simd_supported());
+    copy_kernel.load(std::memory_order_relaxed)(destination, source, size);
+}
+
+void
+arena_fill(void *destination, int value, size_t size)
+{
+    fill_kernel.load(std::memory_order_relaxed)(destination, value, size);
+}
+
+void
+arena_copy(void *destination, const void *source, size_t size)
+{
+    copy_kernel.load(std::memory_order_relaxed)(destination, source, size);
+}
+
+void*
+arena_push_zeroed(memory_arena_t *arena, size_t size, size_t alignment)
+{
+
+    // Pages committed from here on are fresh from the OS, unless they were lazily freed
+    // by a purge, in which case they may still hold their old contents.
+    size_t fresh_offset = arena->capacity;
+    if (arena->purge.mode == ARENA_PURGE_LAZY_FREE && arena->purge.peak_capacity > fresh_offset)
+        fresh_offset = arena->purge.peak_capacity;
+
+    char* result = (char*)arena_push_aligned(arena, size, alignment);
+    if (result == NULL)
+        return NULL;
+
+    size_t start = (size_t)(result - (char*)arena->memory_region);
+    size_t end = start + size;
+    if (end > fresh_offset)
+        end = (start > fresh_offset) ? start : fresh_offset;
+
+    if (end <= start)
+        return result;
+
+    // Clearing up to the next cache line never leaves the page we are already in.
+    size_t rounded_end = (end + 63) & ~(size_t)63;
+    if (rounded_end <= arena->capacity)
+        end = rounded_end;
+
+    arena_fill(result, 0, end - start);
+    return result;
+
+}
+
@@ -0,0 +1,42 @@
+#ifndef CUSTOM_ALLOCATORS_BULK_MEMORY_H
+#define CUSTOM_ALLOCATORS_BULK_MEMORY_H
+#include "custom_memory.h"
+
+// Bulk fill and copy routines for arena memory, with SSE2, AVX2 and AVX-512 versions
+// picked at runtime for the best the CPU (and OS) support. The middle of every block is
+// written with aligned vector stores; blocks of ARENA_BULK_NONTEMPORAL_THRESHOLD bytes
+// or more use non-temporal (streaming) stores instead, which skip the cache so filling
+// or copying a huge block doesn't evict everything else. Small blocks go straight to
+// memset() and memcpy(), which are hard to beat below a few vectors.
+//
+// arena_copy() has memcpy() semantics; source and destination must not overlap. On
+// anything other than x86-64 every routine falls back to the C library.
+
+#ifndef ARENA_BULK_NONTEMPORAL_THRESHOLD
+#   define ARENA_BULK_NONTEMPORAL_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+enum arena_simd_level
+{
+    ARENA_SIMD_LIBC,
+    ARENA_SIMD_SSE2,
+    ARENA_SIMD_AVX2,
+    ARENA_SIMD_AVX512,
+};
+
+arena_simd_level arena_simd_supported();
+arena_simd_level arena_simd_selected();
+void   arena_simd_select(arena_simd_level level);
+
+void   arena_fill(void *destination, int value, size_t size);
+void   arena_copy(void *destination, const void *source, size_t size);
+
+// Pushes a block and zeroes it. Memory the arena commits during the push comes fresh
+// from the OS and is already zero, so only the part that was committed before needs
+// clearing, and since everything above the top of the stack is unused, the clear may
+// run past the end of the block to the next vector boundary instead of fiddling with a
+// partial tail.
+void*  arena_push_zeroed(memory_arena_t *arena, size_t size,
+            size_t alignment = alignof(std::max_align_t));
+
+#endif
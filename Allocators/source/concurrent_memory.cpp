@@ -0,0 +1,96 @@
+#include "concurrent_memory.h"
+
+// The backing arena is allocated up front rather than reserved. Growing the commit
+// frontier would need a lock every time a chunk crossed it; on Linux the pages of a
+// committed mapping aren't backed by physical memory until first touch anyway.
+bool
+allocate_concurrent_arena(concurrent_arena_t *arena, size_t request_size)
+{
+
+    if (!allocate_arena(&arena->backing, request_size))
+        return false;
+
+    arena->generation.store(0, std::memory_order_relaxed);
+    arena->offset.store(0, std::memory_order_relaxed);
+    return true;
+
+}
+
+void
+release_concurrent_arena(concurrent_arena_t *arena)
+{
+    release_arena(&arena->backing);
+    arena->offset.store(0, std::memory_order_relaxed);
+}
+
+// Not thread-safe; every thread pushing into the arena must be done with it. Bumping
+// the generation makes every thread's cached chunk stale on its next push.
+void
+concurrent_arena_reset(concurrent_arena_t *arena)
+{
+    arena->offset.store(0, std::memory_order_relaxed);
+    arena->generation.fetch_add(1, std::memory_order_release);
+}
+
+void
+concurrent_arena_cache_initialize(concurrent_arena_cache_t *cache, concurrent_arena_t *arena)
+{
+    cache->arena = arena;
+    cache->cursor = NULL;
+    cache->end = NULL;
+    cache->generation = 0;
+}
+
+// Claims a block straight off the shared counter. The counter may run past the end
+// of the arena when it fills up; the push that overshoots simply fails, and so does
+// every push after it until the arena is reset.
+void*
+concurrent_arena_push_shared(concurrent_arena_t *arena, size_t size, size_t alignment)
+{
+
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    size_t capacity = arena->backing.capacity;
+    if (size > capacity)
+        return NULL;
+
+    // Reserve enough for the worst-case padding so one fetch_add is all we need.
+    size_t claim = size + alignment - 1;
+    size_t start = arena->offset.fetch_add(claim, std::memory_order_relaxed);
+    if (start > capacity || claim > capacity - start)
+        return NULL;
+
+    size_t address = ((size_t)arena->backing.memory_region) + start;
+    address = (address + alignment - 1) & ~(alignment - 1);
+    return (void*)address;
+
+}
+
+// Slow path of concurrent_arena_push; grabs a new chunk for this thread. Requests
+// bigger than a quarter chunk would waste too much of it, so they skip the cache and
+// go straight to the counter.
+void*
+concurrent_arena_refill(concurrent_arena_cache_t *cache, size_t size, size_t alignment)
+{
+
+    concurrent_arena_t* arena = cache->arena;
+    if (size > CONCURRENT_ARENA_CHUNK_SIZE / 4 || alignment > CONCURRENT_ARENA_CHUNK_SIZE / 4)
+        return concurrent_arena_push_shared(arena, size, alignment);
+
+    size_t generation = arena->generation.load(std::memory_order_acquire);
+    char* chunk = (char*)concurrent_arena_push_shared(arena,
+            CONCURRENT_ARENA_CHUNK_SIZE, CONCURRENT_ARENA_CACHE_LINE);
+    if (chunk == NULL)
+        return NULL;
+
+    cache->cursor = chunk;
+    cache->end = chunk + CONCURRENT_ARENA_CHUNK_SIZE;
+    cache->generation = generation;
+
+    size_t padding = (size_t)(0 - (size_t)cache->cursor) & (alignment - 1);
+    void* result = cache->cursor + padding;
+    cache->cursor += padding + size;
+    return result;
+
+}
+
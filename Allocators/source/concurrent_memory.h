@@ -0,0 +1,73 @@
+#ifndef CUSTOM_ALLOCATORS_CONCURRENT_MEMORY_H
+#define CUSTOM_ALLOCATORS_CONCURRENT_MEMORY_H
+#include <atomic>
+#include "custom_memory.h"
+
+// A bump allocator that several threads can push into at once. The top of the stack
+// is an atomic offset that threads fetch_add on. Hammering one counter from every core
+// turns it into the hottest cache line in the process, so each thread instead grabs a
+// chunk of CONCURRENT_ARENA_CHUNK_SIZE bytes at a time into its own cache and bumps
+// through that privately. Only running out of chunk touches the shared counter.
+//
+// Pushes never free individually; the whole arena is reset at once when every thread
+// is done with it (end of frame, end of request, and so on).
+#ifndef CONCURRENT_ARENA_CHUNK_SIZE
+#   define CONCURRENT_ARENA_CHUNK_SIZE (32 * 1024)
+#endif
+
+#define CONCURRENT_ARENA_CACHE_LINE 64
+
+struct concurrent_arena_t
+{
+
+    // Read-mostly fields, kept away from the counter so reads don't false-share.
+    memory_arena_t backing;
+    std::atomic<size_t> generation;
+
+    alignas(CONCURRENT_ARENA_CACHE_LINE) std::atomic<size_t> offset;
+    char offset_padding[CONCURRENT_ARENA_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+};
+
+// Owned by exactly one thread. The generation lets a reset invalidate every thread's
+// cached chunk without having to track down the caches themselves.
+struct concurrent_arena_cache_t
+{
+    concurrent_arena_t* arena;
+    char* cursor;
+    char* end;
+    size_t generation;
+};
+
+bool   allocate_concurrent_arena(concurrent_arena_t *arena, size_t request_size);
+void   release_concurrent_arena(concurrent_arena_t *arena);
+void   concurrent_arena_reset(concurrent_arena_t *arena);
+void   concurrent_arena_cache_initialize(concurrent_arena_cache_t *cache, concurrent_arena_t *arena);
+void*  concurrent_arena_push_shared(concurrent_arena_t *arena, size_t size, size_t alignment);
+void*  concurrent_arena_refill(concurrent_arena_cache_t *cache, size_t size, size_t alignment);
+
+// The fast path; a private pointer bump with no atomics. Returns NULL once the arena
+// has run out of space.
+inline void*
+concurrent_arena_push(concurrent_arena_cache_t *cache, size_t size,
+        size_t alignment = alignof(std::max_align_t))
+{
+
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    size_t padding = (size_t)(0 - (size_t)cache->cursor) & (alignment - 1);
+    if (cache->cursor != NULL
+            && cache->generation == cache->arena->generation.load(std::memory_order_relaxed)
+            && size <= (size_t)(cache->end - cache->cursor)
+            && padding <= (size_t)(cache->end - cache->cursor) - size)
+    {
+        void* result = cache->cursor + padding;
+        cache->cursor += padding + size;
+        return result;
+    }
+
+    return concurrent_arena_refill(cache, size, alignment);
+
+}
+
+#endif
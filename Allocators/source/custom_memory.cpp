@@ -1,75 +1,515 @@
-#include <windows.h>
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <sys/mman.h>
+#   include <unistd.h>
+#   include <cstdio>
+#endif
+#include <cstring>
 #include "custom_memory.h"
 
+#if defined(__linux__) && !defined(MAP_HUGE_SHIFT)
+#   define MAP_HUGE_SHIFT 26
+#endif
+
+// Rounds a request up to a whole number of pages of the given size.
+static inline size_t
+get_nearest_page_size_multiple(size_t size_request, size_t page_size)
+{
+
+    size_t page_count = (size_request / page_size);
+    if (size_request % page_size != 0)
+        page_count++;
+
+    return page_count * page_size;
+
+}
+
 static inline size_t
+get_system_page_size()
+{
+
+    static size_t page_size = 0;
+    if (page_size == 0)
+    {
+#       if defined(_WIN32)
+            SYSTEM_INFO system_info = {};
+            GetSystemInfo(&system_info);
+            page_size = system_info.dwPageSize;
+#       elif defined(__linux__)
+            page_size = (size_t)sysconf(_SC_PAGESIZE);
+#       endif
+    }
+
+    return page_size;
+
+}
+
+size_t
 get_nearest_page_granularity_size(size_t size_request)
 {
 
     static size_t page_granularity = 0;
     if (page_granularity == 0)
     {
-        SYSTEM_INFO system_info = {};
-        GetSystemInfo(&system_info);
-        page_granularity = system_info.dwAllocationGranularity;
+#       if defined(_WIN32)
+            SYSTEM_INFO system_info = {};
+            GetSystemInfo(&system_info);
+            page_granularity = system_info.dwAllocationGranularity;
+#       elif defined(__linux__)
+            page_granularity = (size_t)sysconf(_SC_PAGESIZE);
+#       endif
     }
 
     // Determine the number of pages we need to allocate.
-    size_t page_count = (size_request / page_granularity);
-    if (size_request % page_granularity != 0)
-        page_count++;
-
-    size_t actual_allocation_size = page_count * page_granularity;
+    size_t actual_allocation_size = get_nearest_page_size_multiple(size_request,
+            page_granularity);
     return actual_allocation_size;
 
 }
 
+// Commits are done at page granularity rather than allocation granularity. On
+// Windows these differ (4KB pages inside 64KB allocations), on Linux they don't.
+static inline size_t
+get_nearest_commit_size(size_t size_request)
+{
+    return get_nearest_page_size_multiple(size_request, get_system_page_size());
+}
+
 void
 arena_pop(memory_arena_t *arena, size_t size)
 {
 
-    if (arena->commit < size)
-        arena->commit = 0;
-    arena->commit -= size;
+    size_t commit = (arena->commit < size) ? 0 : arena->commit - size;
+    if (arena->destructors != NULL)
+        arena_run_destructors(arena, commit);
+    arena->commit = commit;
+    ARENA_RECORD_POP(arena);
+    arena_check_purge(arena);
     return;
 
 }
 
+// The block on top of the stack can be resized in place by moving the top; anything
+// else is copied into a fresh push and the old block is left where it is until the
+// arena is rewound past it.
 void*
-arena_push(memory_arena_t *arena, size_t size)
+arena_realloc(memory_arena_t *arena, void *pointer, size_t old_size, size_t new_size,
+        size_t alignment)
+{
+
+    if (pointer == NULL)
+        return arena_push_aligned(arena, new_size, alignment);
+
+    char* top = ((char*)arena->memory_region) + arena->commit;
+    if (((char*)pointer) + old_size == top && ((size_t)pointer & (alignment - 1)) == 0)
+    {
+        if (new_size <= old_size)
+        {
+            arena->commit -= old_size - new_size;
+            ARENA_RECORD_POP(arena);
+            arena_check_purge(arena);
+            return pointer;
+        }
+
+        if (arena_push(arena, new_size - old_size) == NULL)
+            return NULL;
+        return pointer;
+    }
+
+    if (new_size <= old_size)
+        return pointer;
+
+    void* result = arena_push_aligned(arena, new_size, alignment);
+    if (result != NULL)
+        memcpy(result, pointer, old_size);
+    return result;
+
+}
+
+void
+arena_reset(memory_arena_t *arena)
+{
+
+    if (arena->destructors != NULL)
+        arena_run_destructors(arena, 0);
+    arena->commit = 0;
+    ARENA_RECORD_POP(arena);
+    arena_check_purge(arena);
+
+}
+
+// Destroys every tracked object that lives at or above the given offset, newest first.
+// The list is ordered by address, so we can stop at the first entry below the offset.
+void
+arena_run_destructors(memory_arena_t *arena, size_t commit)
+{
+
+    char* boundary = ((char*)arena->memory_region) + commit;
+    arena_destructor_t* entry = arena->destructors;
+    while (entry != NULL && (char*)entry >= boundary)
+    {
+        // Unlink first, in case the destructor pushes or pops on this arena.
+        arena->destructors = entry->previous;
+        entry->destroy(entry);
+        entry = arena->destructors;
+    }
+
+}
+
+// Called by arena_push when a push crosses the commit frontier. We commit in steps of
+// ARENA_COMMIT_STEP_SIZE so that a run of small pushes doesn't turn into a run of
+// system calls. Fails if the push would run past the end of the reservation.
+bool
+arena_grow_commit(memory_arena_t *arena, size_t size)
+{
+
+    if (size > arena->reserved - arena->commit)
+        return false;
+
+    size_t required_size = arena->commit + size;
+    if (required_size <= arena->capacity)
+        return true;
+
+    // Determine how much we are going to commit this time around.
+    size_t commit_target = arena->capacity + ARENA_COMMIT_STEP_SIZE;
+    if (commit_target < required_size)
+        commit_target = required_size;
+    commit_target = get_nearest_commit_size(commit_target);
+    if (commit_target > arena->reserved)
+        commit_target = arena->reserved;
+
+    char* commit_base = ((char*)arena->memory_region) + arena->capacity;
+    size_t commit_size = commit_target - arena->capacity;
+
+#   if defined(_WIN32)
+        if (VirtualAlloc(commit_base, commit_size, MEM_COMMIT, PAGE_READWRITE) == NULL)
+            return false;
+#   elif defined(__linux__)
+        if (mprotect(commit_base, commit_size, PROT_READ|PROT_WRITE) != 0)
+            return false;
+#   endif
+
+    // Anything we commit below the highest point we've ever committed to was purged
+    // at some point and is now being faulted back in.
+    if (arena->capacity < arena->purge.peak_capacity)
+    {
+        size_t refault_end = (commit_target < arena->purge.peak_capacity)
+            ? commit_target : arena->purge.peak_capacity;
+        arena->purge.refaulted_bytes += refault_end - arena->capacity;
+    }
+
+    arena->capacity = commit_target;
+    if (arena->capacity > arena->purge.peak_capacity)
+        arena->purge.peak_capacity = arena->capacity;
+    return true;
+
+}
+
+void
+arena_set_purge_policy(memory_arena_t *arena, size_t threshold, size_t retain,
+        arena_purge_mode mode)
 {
-    
-    void* offset = ((char*)arena->memory_region) + arena->commit;
-    arena->commit += size;
-    return offset;
+
+    // A threshold at or below the retained slack would purge on every rewind.
+    assert(threshold == 0 || threshold > retain);
+
+    arena->purge.threshold = threshold;
+    arena->purge.retain = retain;
+    arena->purge.mode = mode;
+    if (arena->capacity > arena->purge.peak_capacity)
+        arena->purge.peak_capacity = arena->capacity;
 
 }
 
-bool 
-allocate_arena(memory_arena_t *arena, size_t size_request)
+// Gives the committed pages above the top of the stack (plus the retained slack) back
+// to the OS and pulls the commit frontier down to match, so growing back into them goes
+// through arena_grow_commit and gets counted as a refault.
+void
+arena_purge(memory_arena_t *arena)
 {
 
+    // Explicit huge pages can't be partially decommitted.
+    if (arena->page_backing == ARENA_BACKING_HUGE_PAGES)
+        return;
+
+    size_t keep = arena->commit + arena->purge.retain;
+    if (keep < arena->commit)
+        return;
+    keep = get_nearest_page_size_multiple(keep, arena->page_size);
+    if (keep >= arena->capacity)
+        return;
+
+    char* purge_base = ((char*)arena->memory_region) + keep;
+    size_t purge_size = arena->capacity - keep;
+
+#   if defined(_WIN32)
+        if (!VirtualFree(purge_base, purge_size, MEM_DECOMMIT))
+            return;
+#   elif defined(__linux__)
+        int advice = MADV_DONTNEED;
+#       if defined(MADV_FREE)
+            if (arena->purge.mode == ARENA_PURGE_LAZY_FREE)
+                advice = MADV_FREE;
+#       endif
+        if (madvise(purge_base, purge_size, advice) != 0)
+            return;
+        mprotect(purge_base, purge_size, PROT_NONE);
+#   endif
+
+    arena->capacity = keep;
+    arena->purge.purge_count++;
+    arena->purge.purged_bytes += purge_size;
+
+}
+
+// Reserves a (potentially very large) range of address space without backing it
+// with physical memory. Pages are committed on demand as pushes reach them, so an
+// arena can be sized for the worst case and only pays for what it actually uses.
+bool
+reserve_arena(memory_arena_t *arena, size_t reserve_size, size_t initial_commit)
+{
+
+    size_t size_maximum = get_nearest_page_granularity_size(reserve_size);
+
+#   if defined(_WIN32)
+        void* memory_ptr = VirtualAlloc(NULL, size_maximum, MEM_RESERVE, PAGE_NOACCESS);
+        if (memory_ptr == NULL)
+            return false;
+#   elif defined(__linux__)
+        void* memory_ptr = mmap(NULL, size_maximum, PROT_NONE,
+                MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+        if (memory_ptr == MAP_FAILED)
+            return false;
+#   endif
+
+    arena->memory_region = memory_ptr;
+    arena->commit = 0;
+    arena->capacity = 0;
+    arena->reserved = size_maximum;
+    arena->checkpoint_depth = 0;
+    arena->page_size = get_system_page_size();
+    arena->page_backing = ARENA_BACKING_STANDARD;
+    arena->destructors = NULL;
+    arena->purge = {};
+    ARENA_RECORD_RESET(arena);
+
+    // Commit the initial pages if the caller knows it will need them.
+    if (initial_commit > 0 && !arena_grow_commit(arena, initial_commit))
+    {
+        release_arena(arena);
+        return false;
+    }
+
+    return true;
+
+}
+
+// Attempts to back the arena with huge pages. On Linux we first ask for explicit
+// huge pages, which only works if the administrator reserved some (vm.nr_hugepages).
+// Failing that, we align the region to 2MB and ask for transparent huge pages, which
+// the kernel may or may not honor; arena_huge_page_bytes() tells us what we got.
+static bool
+allocate_huge_page_region(memory_arena_t *arena, size_t size_request, arena_page_size page_size)
+{
+
+#   if defined(_WIN32)
+        // Windows only has the one large page size, and it needs SeLockMemoryPrivilege.
+        size_t large_page_size = (size_t)GetLargePageMinimum();
+        if (large_page_size == 0)
+            return false;
+
+        size_t size_maximum = get_nearest_page_size_multiple(size_request, large_page_size);
+        void* memory_ptr = VirtualAlloc(NULL, size_maximum,
+                MEM_COMMIT|MEM_RESERVE|MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (memory_ptr == NULL)
+            return false;
+
+        arena->page_size = large_page_size;
+        arena->page_backing = ARENA_BACKING_HUGE_PAGES;
+#   elif defined(__linux__)
+        size_t huge_page_size = (page_size == ARENA_PAGES_HUGE_1GB)
+            ? (size_t)1024 * 1024 * 1024
+            : (size_t)2 * 1024 * 1024;
+        size_t size_maximum = get_nearest_page_size_multiple(size_request, huge_page_size);
+        int huge_page_shift = (page_size == ARENA_PAGES_HUGE_1GB) ? 30 : 21;
+        void* memory_ptr = mmap(NULL, size_maximum, PROT_READ|PROT_WRITE,
+                MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|(huge_page_shift << MAP_HUGE_SHIFT),
+                -1, 0);
+
+        if (memory_ptr != MAP_FAILED)
+        {
+            arena->page_size = huge_page_size;
+            arena->page_backing = ARENA_BACKING_HUGE_PAGES;
+        }
+        else
+        {
+            // Transparent huge pages only come in 2MB. Over-map by one huge page so we
+            // can trim the mapping down to a 2MB aligned region.
+            size_t transparent_page_size = (size_t)2 * 1024 * 1024;
+            size_maximum = get_nearest_page_size_multiple(size_request, transparent_page_size);
+            size_t mapping_size = size_maximum + transparent_page_size;
+            char* mapping = (char*)mmap(NULL, mapping_size, PROT_READ|PROT_WRITE,
+                    MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+                return false;
+
+            size_t mapping_address = (size_t)mapping;
+            char* aligned = (char*)((mapping_address + transparent_page_size - 1)
+                    & ~(transparent_page_size - 1));
+            size_t head_size = (size_t)(aligned - mapping);
+            size_t tail_size = mapping_size - head_size - size_maximum;
+            if (head_size > 0) munmap(mapping, head_size);
+            if (tail_size > 0) munmap(aligned + size_maximum, tail_size);
+            memory_ptr = aligned;
+
+            if (madvise(memory_ptr, size_maximum, MADV_HUGEPAGE) == 0)
+            {
+                arena->page_size = transparent_page_size;
+                arena->page_backing = ARENA_BACKING_TRANSPARENT;
+            }
+            else
+            {
+                arena->page_size = get_system_page_size();
+                arena->page_backing = ARENA_BACKING_STANDARD;
+            }
+        }
+#   endif
+
+    arena->memory_region = memory_ptr;
+    arena->commit = 0;
+    arena->capacity = size_maximum;
+    arena->reserved = size_maximum;
+    arena->checkpoint_depth = 0;
+    arena->destructors = NULL;
+    arena->purge = {};
+    ARENA_RECORD_RESET(arena);
+
+    return true;
+
+}
+
+bool
+allocate_arena(memory_arena_t *arena, size_t size_request, arena_page_size page_size)
+{
+
+    // Huge pages are best effort; if we can't get them, we fall through to the
+    // regular path below.
+    if (page_size != ARENA_PAGES_DEFAULT
+            && allocate_huge_page_region(arena, size_request, page_size))
+        return true;
+
     // Determine the maximum size.
     size_t size_maximum = get_nearest_page_granularity_size(size_request);
 
     // Allocate the region first.
-    void* memory_ptr = VirtualAlloc(NULL, size_maximum,
-            MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
-    if (memory_ptr == NULL)
-        return false;
+#   if defined(_WIN32)
+        void* memory_ptr = VirtualAlloc(NULL, size_maximum,
+                MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+        if (memory_ptr == NULL)
+            return false;
+
+        // Now inspect the allocation and determine the actual size.
+        size_t size_actual = 0;
+        MEMORY_BASIC_INFORMATION memory_information = {};
+        VirtualQuery(memory_ptr, &memory_information, sizeof(MEMORY_BASIC_INFORMATION));
+        size_actual = (size_t)memory_information.RegionSize;
+#   elif defined(__linux__)
+        void* memory_ptr = mmap(NULL, size_maximum, PROT_READ|PROT_WRITE,
+                MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (memory_ptr == MAP_FAILED)
+            return false;
 
-    // Now inspect the allocation and determine the actual size.
-    size_t size_actual = 0;
-    MEMORY_BASIC_INFORMATION memory_information = {};
-    VirtualQuery(memory_ptr, &memory_information, sizeof(MEMORY_BASIC_INFORMATION));
-    size_actual = (size_t)memory_information.RegionSize;
+        // The kernel gives us exactly what we asked for once it is page-rounded.
+        size_t size_actual = size_maximum;
+#   endif
 
     // Fill out the memory arena struct.
     arena->memory_region = memory_ptr;
     arena->commit = 0;
     arena->capacity = size_actual;
+    arena->reserved = size_actual;
+    arena->checkpoint_depth = 0;
+    arena->page_size = get_system_page_size();
+    arena->page_backing = ARENA_BACKING_STANDARD;
+    arena->destructors = NULL;
+    arena->purge = {};
+    ARENA_RECORD_RESET(arena);
 
     return true;
 
 }
 
+void
+release_arena(memory_arena_t *arena)
+{
+
+    if (arena->memory_region == NULL)
+        return;
+
+    // Anything still alive on the arena goes down with it.
+    if (arena->destructors != NULL)
+        arena_run_destructors(arena, 0);
+
+#   if defined(_WIN32)
+        VirtualFree(arena->memory_region, 0, MEM_RELEASE);
+#   elif defined(__linux__)
+        munmap(arena->memory_region, arena->reserved);
+#   endif
+
+    arena->memory_region = NULL;
+    arena->capacity = 0;
+    arena->commit = 0;
+    arena->reserved = 0;
+    arena->checkpoint_depth = 0;
+    arena->page_backing = ARENA_BACKING_STANDARD;
+    arena->destructors = NULL;
+
+}
+
+// Reports how many bytes of the arena are actually sitting on huge pages right now.
+// Explicit huge pages are all-or-nothing. Transparent huge pages are handed out (and
+// broken up) by the kernel as it sees fit, so we have to go and ask it.
+size_t
+arena_huge_page_bytes(memory_arena_t *arena)
+{
+
+    if (arena->page_backing == ARENA_BACKING_HUGE_PAGES)
+        return arena->capacity;
+    if (arena->page_backing != ARENA_BACKING_TRANSPARENT)
+        return 0;
+
+    size_t huge_page_bytes = 0;
+
+#   if defined(__linux__)
+        FILE* smaps = fopen("/proc/self/smaps", "r");
+        if (smaps == NULL)
+            return 0;
+
+        size_t region_start = (size_t)arena->memory_region;
+        size_t region_end = region_start + arena->reserved;
+        bool inside_region = false;
+
+        char line[512];
+        while (fgets(line, sizeof(line), smaps) != NULL)
+        {
+            unsigned long mapping_start = 0;
+            unsigned long mapping_end = 0;
+            size_t kilobytes = 0;
+            if (sscanf(line, "%lx-%lx ", &mapping_start, &mapping_end) == 2)
+            {
+                inside_region = (mapping_start < region_end && mapping_end > region_start);
+            }
+            else if (inside_region && sscanf(line, "AnonHugePages: %zu kB", &kilobytes) == 1)
+            {
+                huge_page_bytes += kilobytes * 1024;
+            }
+        }
+
+        fclose(smaps);
+#   endif
+
+    return huge_page_bytes;
+
+}
 
@@ -1,18 +1,324 @@
-#ifndef CUSTOM_ALLOCATORS_MEMORY_H 
-#define CUSTOM_ALLOCATORS_MEMORY_H 
+#ifndef CUSTOM_ALLOCATORS_MEMORY_H
+#define CUSTOM_ALLOCATORS_MEMORY_H
+#include <cstddef>
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include "arena_statistics.h"
 
+// The number of bytes a reserved arena commits at a time once a push crosses the
+// commit frontier. Larger steps mean fewer trips to the OS, smaller steps mean
+// less physical memory sitting around unused. Rounded up to the page size.
+#ifndef ARENA_COMMIT_STEP_SIZE
+#   define ARENA_COMMIT_STEP_SIZE (64 * 1024)
+#endif
+
+// The page size an arena is allowed to ask the OS for. Huge pages cut down on TLB
+// misses for big arenas that get accessed all over the place. They are a request,
+// not a guarantee; the arena records what the OS actually gave it.
+enum arena_page_size
+{
+    ARENA_PAGES_DEFAULT,
+    ARENA_PAGES_HUGE_2MB,
+    ARENA_PAGES_HUGE_1GB,
+};
+
+enum arena_page_backing
+{
+    ARENA_BACKING_STANDARD,     // Regular pages.
+    ARENA_BACKING_HUGE_PAGES,   // Explicit huge pages (MAP_HUGETLB, MEM_LARGE_PAGES).
+    ARENA_BACKING_TRANSPARENT,  // Transparent huge pages were requested through madvise.
+};
+
+// Pushed just in front of a non-trivially-destructible object by arena_push_object.
+// The entries form a list from the most recent push backwards, so walking it runs
+// destructors in the reverse order of construction. The object sits right after the
+// entry, aligned for its type; the destroy function knows where to find it.
+struct arena_destructor_t
+{
+    arena_destructor_t* previous;
+    void (*destroy)(arena_destructor_t* entry);
+};
+
+// How an arena hands pages back to the OS when it is rewound. Decommitting returns
+// the memory right away (MADV_DONTNEED, MEM_DECOMMIT). Lazy freeing (MADV_FREE) lets
+// the kernel reclaim the pages only when it is under memory pressure, which is cheaper
+// if the arena is likely to grow back soon. Windows always decommits.
+enum arena_purge_mode
+{
+    ARENA_PURGE_DECOMMIT,
+    ARENA_PURGE_LAZY_FREE,
+};
+
+// Purging is off until arena_set_purge_policy is called. Once the committed pages
+// above the top of the stack exceed "threshold" bytes, everything above the top plus
+// "retain" bytes is given back. The gap between the two is the hysteresis; a workload
+// that oscillates within it never purges.
+struct arena_purge_state_t
+{
+    size_t threshold;
+    size_t retain;
+    arena_purge_mode mode;
+
+    size_t peak_capacity;
+    size_t purge_count;
+    size_t purged_bytes;
+    size_t refaulted_bytes;
+};
+
+// The arena owns a region of address space. Only the first "capacity" bytes are
+// backed by committed pages; the rest of the "reserved" range is address space we
+// hold onto so the arena can grow in place without moving. Arenas created with
+// allocate_arena commit everything up front, so capacity and reserved are equal.
 struct memory_arena_t
 {
     void* memory_region;
     size_t capacity;
     size_t commit;
+    size_t reserved;
+    size_t checkpoint_depth;
+    size_t page_size;
+    arena_page_backing page_backing;
+    arena_destructor_t* destructors;
+    arena_purge_state_t purge;
+
+#if ARENA_INSTRUMENTATION
+    arena_statistics_t statistics;
+#endif
 };
 
-bool   allocate_arena(memory_arena_t *arena, size_t request_size);
-void*  arena_push(memory_arena_t *arena, size_t size);
+bool   allocate_arena(memory_arena_t *arena, size_t request_size,
+            arena_page_size page_size = ARENA_PAGES_DEFAULT);
+bool   reserve_arena(memory_arena_t *arena, size_t reserve_size, size_t initial_commit = 0);
+void   release_arena(memory_arena_t *arena);
+bool   arena_grow_commit(memory_arena_t *arena, size_t size);
 void   arena_pop(memory_arena_t *arena, size_t size);
-#define arena_push_struct(arena, type) ((type*)arena_push(arena, sizeof(type)))
-#define arena_push_array(arena, type, count) ((type*)arena_push(arena, sizeof(type)*count))
+void*  arena_realloc(memory_arena_t *arena, void *pointer, size_t old_size, size_t new_size,
+            size_t alignment = alignof(std::max_align_t));
+void   arena_reset(memory_arena_t *arena);
+void   arena_run_destructors(memory_arena_t *arena, size_t commit);
+size_t arena_huge_page_bytes(memory_arena_t *arena);
+void   arena_set_purge_policy(memory_arena_t *arena, size_t threshold, size_t retain,
+            arena_purge_mode mode = ARENA_PURGE_DECOMMIT);
+void   arena_purge(memory_arena_t *arena);
+
+// Rounds a request up to the granularity virtual memory is handed out in; the page size
+// on Linux, the (larger) allocation granularity on Windows.
+size_t get_nearest_page_granularity_size(size_t size_request);
+
+// Called after anything that lowers the top of the stack. A single compare when the
+// purge policy is off or there isn't enough to give back.
+inline void
+arena_check_purge(memory_arena_t *arena)
+{
+    if (arena->purge.threshold != 0 && arena->capacity - arena->commit > arena->purge.threshold)
+        arena_purge(arena);
+}
+
+// Pushes are the hot path, so they live in the header and stay a pointer bump.
+// Only when a push crosses the commit frontier do we call out to commit more pages,
+// and a push that would run off the end of the reservation returns NULL.
+inline void*
+arena_push(memory_arena_t *arena, size_t size)
+{
+
+    if (size > arena->capacity - arena->commit)
+    {
+        if (!arena_grow_commit(arena, size))
+        {
+            ARENA_RECORD_PUSH(arena, size, false);
+            return NULL;
+        }
+    }
+
+    void* offset = ((char*)arena->memory_region) + arena->commit;
+    arena->commit += size;
+    ARENA_RECORD_PUSH(arena, size, true);
+    return offset;
+
+}
+
+// Same as arena_push, but pads the push so the returned address is a multiple of
+// alignment, which must be a power of two. The padding is wasted until the next pop.
+inline void*
+arena_push_aligned(memory_arena_t *arena, size_t size, size_t alignment)
+{
+
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    size_t address = ((size_t)arena->memory_region) + arena->commit;
+    size_t padding = (size_t)(0 - address) & (alignment - 1);
+    if (size > (size_t)-1 - padding)
+        return NULL;
+
+    if (padding + size > arena->capacity - arena->commit)
+    {
+        if (!arena_grow_commit(arena, padding + size))
+        {
+            ARENA_RECORD_PUSH(arena, size, false);
+            return NULL;
+        }
+    }
+
+    void* offset = ((char*)arena->memory_region) + arena->commit + padding;
+    arena->commit += padding + size;
+    ARENA_RECORD_PUSH(arena, size, true);
+    return offset;
+
+}
+
+// Typed pushes honor the alignment requirements of the type, so doubles, SIMD
+// vectors and atomics never straddle a boundary after an odd-sized push.
+template <typename T> inline T*
+arena_push_type(memory_arena_t *arena)
+{
+    return (T*)arena_push_aligned(arena, sizeof(T), alignof(T));
+}
+
+template <typename T> inline T*
+arena_push_type_array(memory_arena_t *arena, size_t count)
+{
+    if (count > (size_t)-1 / sizeof(T))
+        return NULL;
+    return (T*)arena_push_aligned(arena, sizeof(T) * count, alignof(T));
+}
+
+#define arena_push_struct(arena, type) (arena_push_type<type>(arena))
+#define arena_push_array(arena, type, count) (arena_push_type_array<type>(arena, count))
+
+template <typename T> void
+arena_destroy_object(arena_destructor_t *entry)
+{
+    size_t address = ((size_t)entry) + sizeof(arena_destructor_t);
+    address = (address + alignof(T) - 1) & ~(alignof(T) - 1);
+    ((T*)address)->~T();
+}
+
+// Constructs a T on the arena. If T has a non-trivial destructor, a destructor entry
+// is pushed along with it so that popping, rewinding, resetting or releasing the arena
+// past the object destroys it. Trivially destructible types are just an aligned push.
+template <typename T, typename... Args> T*
+arena_push_object(memory_arena_t *arena, Args&&... args)
+{
+
+    if constexpr (std::is_trivially_destructible<T>::value)
+    {
+        T* object = arena_push_type<T>(arena);
+        if (object == NULL)
+            return NULL;
+        return ::new ((void*)object) T(static_cast<Args&&>(args)...);
+    }
+    else
+    {
+        // Push the entry and the object as one block so that the arena can't be
+        // rewound between the two.
+        size_t alignment = (alignof(T) > alignof(arena_destructor_t))
+            ? alignof(T) : alignof(arena_destructor_t);
+        size_t object_offset = (sizeof(arena_destructor_t) + alignof(T) - 1) & ~(alignof(T) - 1);
+        size_t block_size = object_offset + sizeof(T);
+
+        // Over-align the entry so the object after it comes out aligned too.
+        char* block = (char*)arena_push_aligned(arena, block_size, alignment);
+        if (block == NULL)
+            return NULL;
+
+        T* object = ::new ((void*)(block + object_offset)) T(static_cast<Args&&>(args)...);
+
+        // Only link the entry once construction succeeded.
+        arena_destructor_t* entry = (arena_destructor_t*)block;
+        entry->previous = arena->destructors;
+        entry->destroy = arena_destroy_object<T>;
+        arena->destructors = entry;
+
+        return object;
+    }
+
+}
+
+// A checkpoint remembers where the top of the stack was so that everything pushed
+// after it can be released in one go, no matter how many pushes happened. Checkpoints
+// nest; they must be restored in the reverse order they were taken, which debug builds
+// will assert on.
+struct arena_checkpoint_t
+{
+    memory_arena_t* arena;
+    size_t commit;
+    size_t depth;
+};
+
+inline arena_checkpoint_t
+arena_checkpoint(memory_arena_t *arena)
+{
+    arena_checkpoint_t checkpoint = {};
+    checkpoint.arena = arena;
+    checkpoint.commit = arena->commit;
+    checkpoint.depth = ++arena->checkpoint_depth;
+    return checkpoint;
+}
+
+inline void
+arena_restore(arena_checkpoint_t checkpoint)
+{
+
+    memory_arena_t* arena = checkpoint.arena;
+
+    // Restoring an outer checkpoint while an inner one is still live, or restoring
+    // one twice, means somebody is about to free memory that is still in use.
+    assert(checkpoint.depth == arena->checkpoint_depth);
+    assert(checkpoint.commit <= arena->commit);
+
+    if (arena->destructors != NULL)
+        arena_run_destructors(arena, checkpoint.commit);
+    arena->commit = checkpoint.commit;
+    arena->checkpoint_depth--;
+    ARENA_RECORD_POP(arena);
+    arena_check_purge(arena);
+
+}
+
+// Scoped version of the above; takes a checkpoint on construction and rewinds the
+// arena when it goes out of scope. Useful for per-frame or per-request scratch.
+struct arena_scope_t
+{
+
+    arena_scope_t(memory_arena_t *arena) : checkpoint(arena_checkpoint(arena)) { }
+    ~arena_scope_t() { arena_restore(checkpoint); }
+
+    arena_scope_t(const arena_scope_t&) = delete;
+    arena_scope_t& operator=(const arena_scope_t&) = delete;
+
+    arena_checkpoint_t checkpoint;
 
+};
+
+// With call-site tagging on, pushes made through these macros remember the file and
+// line they came from. Pushes made inside the header above are tagged with the caller
+// of whatever helper made them, or not at all for the templated helpers.
+#if ARENA_INSTRUMENTATION && ARENA_INSTRUMENTATION_CALL_SITES
+
+inline void*
+arena_push_at(memory_arena_t *arena, size_t size, const char* file, int line)
+{
+    void* result = arena_push(arena, size);
+    if (result != NULL)
+        arena_statistics_record_call_site(arena, size, file, line);
+    return result;
+}
+
+inline void*
+arena_push_aligned_at(memory_arena_t *arena, size_t size, size_t alignment,
+        const char* file, int line)
+{
+    void* result = arena_push_aligned(arena, size, alignment);
+    if (result != NULL)
+        arena_statistics_record_call_site(arena, size, file, line);
+    return result;
+}
+
+#   define arena_push(arena, size) arena_push_at(arena, size, __FILE__, __LINE__)
+#   define arena_push_aligned(arena, size, alignment) \
+        arena_push_aligned_at(arena, size, alignment, __FILE__, __LINE__)
+
+#endif
 
 #endif
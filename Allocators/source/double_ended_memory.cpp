@@ -0,0 +1,27 @@
+#include "double_ended_memory.h"
+
+bool
+allocate_double_ended_arena(double_ended_arena_t *arena, size_t request_size)
+{
+
+    if (!allocate_arena(&arena->backing, request_size))
+        return false;
+
+    arena->bottom = 0;
+    arena->top = arena->backing.capacity;
+    arena->collision_count = 0;
+    arena->checkpoint_depth[DOUBLE_ENDED_BOTTOM] = 0;
+    arena->checkpoint_depth[DOUBLE_ENDED_TOP] = 0;
+
+    return true;
+
+}
+
+void
+release_double_ended_arena(double_ended_arena_t *arena)
+{
+    release_arena(&arena->backing);
+    arena->bottom = 0;
+    arena->top = 0;
+}
+
@@ -0,0 +1,179 @@
+#ifndef CUSTOM_ALLOCATORS_DOUBLE_ENDED_MEMORY_H
+#define CUSTOM_ALLOCATORS_DOUBLE_ENDED_MEMORY_H
+#include "custom_memory.h"
+
+// A double-ended arena is one region with a stack at each end. The bottom stack grows
+// up and is meant for long-lived (persistent) data, the top stack grows down and is
+// meant for short-lived (temporary) data. Each side can be pushed, popped, rewound and
+// reset on its own, and neither side has a fixed share of the region; whichever one
+// needs more space simply takes it. When the two stacks would meet, the push fails
+// and the collision is counted.
+//
+// The backing region comes from allocate_arena. On Linux untouched pages of the region
+// cost nothing, so the middle of the arena only becomes resident as the stacks reach it.
+
+enum double_ended_side
+{
+    DOUBLE_ENDED_BOTTOM,
+    DOUBLE_ENDED_TOP,
+};
+
+struct double_ended_arena_t
+{
+    memory_arena_t backing;
+    size_t bottom;              // Bytes in use from the start of the region.
+    size_t top;                 // Offset of the lowest byte in use by the top stack.
+    size_t collision_count;
+    size_t checkpoint_depth[2];
+};
+
+struct double_ended_checkpoint_t
+{
+    double_ended_arena_t* arena;
+    double_ended_side side;
+    size_t offset;
+    size_t depth;
+};
+
+bool   allocate_double_ended_arena(double_ended_arena_t *arena, size_t request_size);
+void   release_double_ended_arena(double_ended_arena_t *arena);
+
+inline size_t
+double_ended_free_space(double_ended_arena_t *arena)
+{
+    return arena->top - arena->bottom;
+}
+
+inline void*
+double_ended_push_bottom(double_ended_arena_t *arena, size_t size,
+        size_t alignment = alignof(std::max_align_t))
+{
+
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    size_t address = ((size_t)arena->backing.memory_region) + arena->bottom;
+    size_t padding = (size_t)(0 - address) & (alignment - 1);
+    size_t available = arena->top - arena->bottom;
+    if (padding > available || size > available - padding)
+    {
+        arena->collision_count++;
+        return NULL;
+    }
+
+    arena->bottom += padding + size;
+    return (void*)(address + padding);
+
+}
+
+inline void*
+double_ended_push_top(double_ended_arena_t *arena, size_t size,
+        size_t alignment = alignof(std::max_align_t))
+{
+
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    // Grow down from the top, then round the start down to the alignment.
+    size_t base = (size_t)arena->backing.memory_region;
+    size_t available = arena->top - arena->bottom;
+    if (size > available)
+    {
+        arena->collision_count++;
+        return NULL;
+    }
+
+    size_t address = (base + arena->top - size) & ~(alignment - 1);
+    if (address < base + arena->bottom)
+    {
+        arena->collision_count++;
+        return NULL;
+    }
+
+    arena->top = address - base;
+    return (void*)address;
+
+}
+
+inline void*
+double_ended_push(double_ended_arena_t *arena, double_ended_side side, size_t size,
+        size_t alignment = alignof(std::max_align_t))
+{
+    return (side == DOUBLE_ENDED_BOTTOM)
+        ? double_ended_push_bottom(arena, size, alignment)
+        : double_ended_push_top(arena, size, alignment);
+}
+
+// Popping past the start of a side simply empties it.
+inline void
+double_ended_pop(double_ended_arena_t *arena, double_ended_side side, size_t size)
+{
+
+    if (side == DOUBLE_ENDED_BOTTOM)
+    {
+        arena->bottom = (arena->bottom < size) ? 0 : arena->bottom - size;
+    }
+    else
+    {
+        size_t end = arena->backing.capacity;
+        arena->top = (size > end - arena->top) ? end : arena->top + size;
+    }
+
+}
+
+inline void
+double_ended_reset(double_ended_arena_t *arena, double_ended_side side)
+{
+    if (side == DOUBLE_ENDED_BOTTOM)
+        arena->bottom = 0;
+    else
+        arena->top = arena->backing.capacity;
+}
+
+// Checkpoints work like the ones on memory_arena_t, one nesting stack per side.
+inline double_ended_checkpoint_t
+double_ended_checkpoint(double_ended_arena_t *arena, double_ended_side side)
+{
+    double_ended_checkpoint_t checkpoint = {};
+    checkpoint.arena = arena;
+    checkpoint.side = side;
+    checkpoint.offset = (side == DOUBLE_ENDED_BOTTOM) ? arena->bottom : arena->top;
+    checkpoint.depth = ++arena->checkpoint_depth[side];
+    return checkpoint;
+}
+
+inline void
+double_ended_restore(double_ended_checkpoint_t checkpoint)
+{
+
+    double_ended_arena_t* arena = checkpoint.arena;
+    assert(checkpoint.depth == arena->checkpoint_depth[checkpoint.side]);
+
+    if (checkpoint.side == DOUBLE_ENDED_BOTTOM)
+    {
+        assert(checkpoint.offset <= arena->bottom);
+        arena->bottom = checkpoint.offset;
+    }
+    else
+    {
+        assert(checkpoint.offset >= arena->top);
+        arena->top = checkpoint.offset;
+    }
+
+    arena->checkpoint_depth[checkpoint.side]--;
+
+}
+
+struct double_ended_scope_t
+{
+
+    double_ended_scope_t(double_ended_arena_t *arena, double_ended_side side)
+        : checkpoint(double_ended_checkpoint(arena, side)) { }
+    ~double_ended_scope_t() { double_ended_restore(checkpoint); }
+
+    double_ended_scope_t(const double_ended_scope_t&) = delete;
+    double_ended_scope_t& operator=(const double_ended_scope_t&) = delete;
+
+    double_ended_checkpoint_t checkpoint;
+
+};
+
+#endif
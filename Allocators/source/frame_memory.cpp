@@ -0,0 +1,77 @@
+#include "frame_memory.h"
+
+bool
+allocate_frame_allocator(frame_allocator_t *frames, size_t buffer_count,
+        size_t buffer_reserve_size)
+{
+
+    assert(buffer_count > 0 && buffer_count <= FRAME_ALLOCATOR_MAX_BUFFERS);
+
+    *frames = {};
+    for (size_t i = 0; i < buffer_count; i++)
+    {
+        if (!reserve_arena(&frames->buffers[i], buffer_reserve_size))
+        {
+            for (size_t j = 0; j < i; j++)
+                release_arena(&frames->buffers[j]);
+            return false;
+        }
+    }
+
+    frames->buffer_count = buffer_count;
+    frames->frame_index = 0;
+    frames->current = &frames->buffers[0];
+
+    return true;
+
+}
+
+void
+release_frame_allocator(frame_allocator_t *frames)
+{
+
+    for (size_t i = 0; i < frames->buffer_count; i++)
+        release_arena(&frames->buffers[i]);
+
+    frames->buffer_count = 0;
+    frames->current = NULL;
+
+}
+
+void
+frame_allocator_begin_frame(frame_allocator_t *frames)
+{
+
+    // Book the frame that just ended before moving on.
+    size_t usage = frames->current->commit;
+    frames->usage_history[frames->frame_index % FRAME_ALLOCATOR_HISTORY] = usage;
+    if (usage > frames->peak_frame_usage)
+        frames->peak_frame_usage = usage;
+
+    // The buffer we rotate into was last used buffer_count frames ago; nobody may
+    // look at it any more.
+    frames->frame_index++;
+    frames->current = &frames->buffers[frames->frame_index % frames->buffer_count];
+    arena_reset(frames->current);
+
+}
+
+// Averaged over the completed frames still in the history.
+size_t
+frame_allocator_average_usage(frame_allocator_t *frames)
+{
+
+    size_t frame_count = frames->frame_index;
+    if (frame_count > FRAME_ALLOCATOR_HISTORY)
+        frame_count = FRAME_ALLOCATOR_HISTORY;
+    if (frame_count == 0)
+        return 0;
+
+    size_t total = 0;
+    for (size_t i = 0; i < frame_count; i++)
+        total += frames->usage_history[i];
+
+    return total / frame_count;
+
+}
+
@@ -0,0 +1,64 @@
+#ifndef CUSTOM_ALLOCATORS_FRAME_MEMORY_H
+#define CUSTOM_ALLOCATORS_FRAME_MEMORY_H
+#include "custom_memory.h"
+
+// A frame allocator rotating through a small ring of arenas. Each frame pushes into its
+// own arena, and beginning a frame resets the arena that was used buffer_count frames
+// ago. With two buffers (double buffering) everything pushed during a frame is still
+// readable during the next one, which is what you want when one frame's results feed
+// the next; more buffers keep more history around.
+//
+// Each buffer is a reserve_arena, so its commit follows what the busiest frame actually
+// used rather than a guess made up front.
+
+#ifndef FRAME_ALLOCATOR_MAX_BUFFERS
+#   define FRAME_ALLOCATOR_MAX_BUFFERS 4
+#endif
+
+#ifndef FRAME_ALLOCATOR_HISTORY
+#   define FRAME_ALLOCATOR_HISTORY 64
+#endif
+
+struct frame_allocator_t
+{
+    memory_arena_t buffers[FRAME_ALLOCATOR_MAX_BUFFERS];
+    size_t buffer_count;
+    size_t frame_index;
+    memory_arena_t* current;
+
+    // Bytes pushed by each of the last FRAME_ALLOCATOR_HISTORY completed frames, indexed
+    // by frame_index % FRAME_ALLOCATOR_HISTORY, and the most any frame has used.
+    size_t usage_history[FRAME_ALLOCATOR_HISTORY];
+    size_t peak_frame_usage;
+};
+
+bool   allocate_frame_allocator(frame_allocator_t *frames, size_t buffer_count,
+            size_t buffer_reserve_size);
+void   release_frame_allocator(frame_allocator_t *frames);
+void   frame_allocator_begin_frame(frame_allocator_t *frames);
+size_t frame_allocator_average_usage(frame_allocator_t *frames);
+
+inline void*
+frame_allocator_push(frame_allocator_t *frames, size_t size,
+        size_t alignment = alignof(std::max_align_t))
+{
+    return arena_push_aligned(frames->current, size, alignment);
+}
+
+// The arena of a frame that is still alive; zero is the current frame, one the frame
+// before it, up to buffer_count - 1.
+inline memory_arena_t*
+frame_allocator_arena(frame_allocator_t *frames, size_t frames_ago = 0)
+{
+    assert(frames_ago < frames->buffer_count && frames_ago <= frames->frame_index);
+    size_t index = (frames->frame_index - frames_ago) % frames->buffer_count;
+    return &frames->buffers[index];
+}
+
+inline size_t
+frame_allocator_current_usage(frame_allocator_t *frames)
+{
+    return frames->current->commit;
+}
+
+#endif
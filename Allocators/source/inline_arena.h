@@ -0,0 +1,230 @@
+#ifndef CUSTOM_ALLOCATORS_INLINE_ARENA_H
+#define CUSTOM_ALLOCATORS_INLINE_ARENA_H
+#include <cstddef>
+#include "custom_memory.h"
+
+// An arena whose memory is a fixed-size buffer inside the arena itself, for scratch
+// space small enough to live on the stack or inside another object. Creating one costs
+// nothing; there is no reservation, no system call and nothing to release. The buffer
+// is left uninitialized, like any other fresh arena memory.
+//
+// It has the same interface as memory_arena_t: arena_push, arena_push_aligned, the
+// arena_push_struct/arena_push_array macros, arena_pop, arena_reset, and checkpoints
+// with arena_checkpoint/arena_restore or a scope. The size is a template parameter and
+// everything is inline, so with a local inline_arena and constant sizes the compiler
+// can fold the bounds checks and pointer math away entirely. There is no destructor
+// list; push objects that need destroying onto a real arena.
+//
+// If a push doesn't fit and the arena was given a spill arena, the push and everything
+// after it go to the spill arena instead, until it is popped or rewound back below the
+// point it spilled at. Without one, a push that doesn't fit returns NULL.
+
+template <size_t N>
+struct inline_arena
+{
+
+    static_assert(N > 0, "An inline arena needs room for something.");
+    static constexpr size_t capacity = N;
+
+    alignas(std::max_align_t) char buffer[N];
+    size_t commit;
+    size_t checkpoint_depth;
+    memory_arena_t* spill;
+    size_t spill_base;          // The spill arena's commit when spilling started.
+    bool spilled;
+
+    explicit inline_arena(memory_arena_t *spill = NULL)
+        : commit(0), checkpoint_depth(0), spill(spill), spill_base(0), spilled(false) { }
+
+    // Copying would leave pointers into the old buffer.
+    inline_arena(const inline_arena&) = delete;
+    inline_arena& operator=(const inline_arena&) = delete;
+
+};
+
+// The cold path, kept separate so the inline checks stay small.
+template <size_t N> void*
+inline_arena_push_spill(inline_arena<N> *arena, size_t size, size_t alignment)
+{
+
+    if (arena->spill == NULL)
+        return NULL;
+
+    if (!arena->spilled)
+    {
+        arena->spill_base = arena->spill->commit;
+        arena->spilled = true;
+    }
+
+    void* result = arena_push_aligned(arena->spill, size, alignment);
+    if (result == NULL && arena->spill->commit == arena->spill_base)
+        arena->spilled = false;
+    return result;
+
+}
+
+// The names are parenthesized so that the call-site macros in custom_memory.h don't
+// expand them; see the overloads at the bottom.
+template <size_t N> inline void*
+(arena_push)(inline_arena<N> *arena, size_t size)
+{
+
+    if (!arena->spilled && size <= N - arena->commit)
+    {
+        void* result = arena->buffer + arena->commit;
+        arena->commit += size;
+        return result;
+    }
+
+    return inline_arena_push_spill(arena, size, 1);
+
+}
+
+template <size_t N> inline void*
+(arena_push_aligned)(inline_arena<N> *arena, size_t size, size_t alignment)
+{
+
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    if (!arena->spilled)
+    {
+        // The buffer itself is aligned for anything up to max_align_t, so for those the
+        // padding depends only on the offset, which the compiler can often see.
+        size_t padding = (alignment <= alignof(std::max_align_t))
+            ? (size_t)(0 - arena->commit) & (alignment - 1)
+            : (size_t)(0 - (size_t)(arena->buffer + arena->commit)) & (alignment - 1);
+        if (padding <= N - arena->commit && size <= N - arena->commit - padding)
+        {
+            void* result = arena->buffer + arena->commit + padding;
+            arena->commit += padding + size;
+            return result;
+        }
+    }
+
+    return inline_arena_push_spill(arena, size, alignment);
+
+}
+
+template <typename T, size_t N> inline T*
+arena_push_type(inline_arena<N> *arena)
+{
+    return (T*)(arena_push_aligned)(arena, sizeof(T), alignof(T));
+}
+
+template <typename T, size_t N> inline T*
+arena_push_type_array(inline_arena<N> *arena, size_t count)
+{
+    if (count > (size_t)-1 / sizeof(T))
+        return NULL;
+    return (T*)(arena_push_aligned)(arena, sizeof(T) * count, alignof(T));
+}
+
+// Pops from the spill arena first, then from the buffer.
+template <size_t N> inline void
+arena_pop(inline_arena<N> *arena, size_t size)
+{
+
+    if (arena->spilled)
+    {
+        size_t spilled_size = arena->spill->commit - arena->spill_base;
+        size_t popped = (size < spilled_size) ? size : spilled_size;
+        arena_pop(arena->spill, popped);
+        size -= popped;
+        if (arena->spill->commit == arena->spill_base)
+            arena->spilled = false;
+    }
+
+    assert(size <= arena->commit);
+    arena->commit -= size;
+
+}
+
+template <size_t N> inline void
+arena_reset(inline_arena<N> *arena)
+{
+
+    if (arena->spilled)
+    {
+        arena_pop(arena->spill, arena->spill->commit - arena->spill_base);
+        arena->spilled = false;
+    }
+
+    arena->commit = 0;
+
+}
+
+template <size_t N>
+struct inline_arena_checkpoint_t
+{
+    inline_arena<N>* arena;
+    size_t commit;
+    size_t spill_commit;
+    size_t depth;
+    bool spilled;
+};
+
+template <size_t N> inline inline_arena_checkpoint_t<N>
+arena_checkpoint(inline_arena<N> *arena)
+{
+    inline_arena_checkpoint_t<N> checkpoint = {};
+    checkpoint.arena = arena;
+    checkpoint.commit = arena->commit;
+    checkpoint.spill_commit = arena->spilled ? arena->spill->commit : 0;
+    checkpoint.depth = ++arena->checkpoint_depth;
+    checkpoint.spilled = arena->spilled;
+    return checkpoint;
+}
+
+template <size_t N> inline void
+arena_restore(inline_arena_checkpoint_t<N> checkpoint)
+{
+
+    inline_arena<N>* arena = checkpoint.arena;
+    assert(checkpoint.depth == arena->checkpoint_depth);
+    assert(checkpoint.commit <= arena->commit);
+
+    if (arena->spilled)
+    {
+        size_t target = checkpoint.spilled ? checkpoint.spill_commit : arena->spill_base;
+        assert(target <= arena->spill->commit);
+        arena_pop(arena->spill, arena->spill->commit - target);
+        arena->spilled = checkpoint.spilled;
+    }
+
+    arena->commit = checkpoint.commit;
+    arena->checkpoint_depth--;
+
+}
+
+template <size_t N>
+struct inline_arena_scope_t
+{
+
+    inline_arena_scope_t(inline_arena<N> *arena) : checkpoint(arena_checkpoint(arena)) { }
+    ~inline_arena_scope_t() { arena_restore(checkpoint); }
+
+    inline_arena_scope_t(const inline_arena_scope_t&) = delete;
+    inline_arena_scope_t& operator=(const inline_arena_scope_t&) = delete;
+
+    inline_arena_checkpoint_t<N> checkpoint;
+
+};
+
+// Pushes onto an inline arena aren't tracked, so the call site is simply dropped.
+#if ARENA_INSTRUMENTATION && ARENA_INSTRUMENTATION_CALL_SITES
+
+template <size_t N> inline void*
+arena_push_at(inline_arena<N> *arena, size_t size, const char*, int)
+{
+    return (arena_push)(arena, size);
+}
+
+template <size_t N> inline void*
+arena_push_aligned_at(inline_arena<N> *arena, size_t size, size_t alignment, const char*, int)
+{
+    return (arena_push_aligned)(arena, size, alignment);
+}
+
+#endif
+
+#endif
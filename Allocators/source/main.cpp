@@ -1,6 +1,22 @@
-#include <windows.h>
+#if defined(_WIN32)
+#   include <windows.h>
+#endif
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <new>
 #include "custom_memory.h"
+#include "scratch_memory.h"
+#include "pool_allocator.h"
+#include "double_ended_memory.h"
+#include "tlsf_allocator.h"
+#include "ring_memory.h"
+#include "frame_memory.h"
+#include "arena_vector.h"
+#include "bulk_memory.h"
+#include "persistent_memory.h"
+#include "string_interner.h"
+#include "inline_arena.h"
 
 class ShapeRectangle
 {
@@ -29,8 +45,13 @@ calculate_area() const
     return width * height;
 }
 
+#if defined(_WIN32)
 int WINAPI
 wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
+#else
+int
+main(int argc, char** argv)
+#endif
 {
 
     memory_arena_t base_arena;
@@ -46,6 +67,22 @@ wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdS
     // Now lets pop back.
     arena_pop(&base_arena, 1024);
 
+    // Keeping track of exact byte counts to pop gets old fast. A scope takes a
+    // checkpoint of the stack and rewinds to it when it goes out of scope, no matter
+    // how many pushes happened in between. Scopes nest just like the stack does.
+    {
+        arena_scope_t frame_scope(&base_arena);
+        for (size_t i = 0; i < 64; i++)
+        {
+            int* my_int = arena_push_struct(&base_arena, int);
+            *my_int = (int)i;
+
+            arena_scope_t inner_scope(&base_arena);
+            double* my_doubles = arena_push_array(&base_arena, double, 4);
+            my_doubles[0] = (double)*my_int;
+        }
+    }
+
     // What happens if we want to construct a class? Well... not straight forward
     // but there is a way! Placement new operator...
     void* rectangle_buffer = arena_push(&base_arena, sizeof(ShapeRectangle));
@@ -59,6 +96,204 @@ wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdS
     my_rec->~ShapeRectangle();
     arena_pop(&base_arena, sizeof(ShapeRectangle)); // Now "delete" rectangle!
 
+    // Or we can let the arena remember for us. arena_push_object records a small
+    // destructor entry next to the object, and anything that rewinds past it (a pop,
+    // a checkpoint restore, a reset, a release) runs the destructor for us.
+    {
+        arena_scope_t object_scope(&base_arena);
+        ShapeRectangle* tracked_rec = arena_push_object<ShapeRectangle>(&base_arena, 5, 5);
+        my_area += tracked_rec->calculate_area();
+    } // ~ShapeRectangle() runs here.
+
+    // Popping only works when objects die in the reverse order they were made. When
+    // they don't, a pool carves fixed-size slots out of the arena and recycles them
+    // through a free list, so rectangles can come and go in any order.
+    memory_arena_t pool_arena;
+    reserve_arena(&pool_arena, 1024 * 1024);
+    object_pool_t<ShapeRectangle> rectangle_pool;
+    pool_initialize(&rectangle_pool, &pool_arena);
+    ShapeRectangle* first_rec = pool_create(&rectangle_pool, 1, 2);
+    pool_create(&rectangle_pool, 5, 6);
+    pool_destroy(&rectangle_pool, first_rec);
+    pool_create(&rectangle_pool, 7, 8); // Reuses first_rec's slot.
+
+    int total_area = 0;
+    pool_for_each(&rectangle_pool, [&](ShapeRectangle& rec) {
+        total_area += rec.calculate_area();
+    });
+
+    pool_reset(&rectangle_pool); // Destroys the two rectangles still alive.
+    release_arena(&pool_arena);
+
+    // Temporary memory doesn't need an arena of its own. Every thread has a couple
+    // of scratch arenas ready to go; a scratch scope hands us one that isn't the
+    // arena we pass in (so we can build results there while using scratch for the
+    // temporaries) and rewinds it when the scope ends.
+    {
+        scratch_scope_t scratch(&base_arena);
+        if (scratch.arena != NULL)
+        {
+            int* temporaries = arena_push_array(scratch.arena, int, 128);
+            int* results = arena_push_struct(&base_arena, int);
+            *results = 0;
+            for (int i = 0; i < 128; i++)
+            {
+                temporaries[i] = i * i;
+                *results += temporaries[i];
+            }
+        }
+    }
+
+    // If we don't know how much memory we need up front, we can reserve a large
+    // range of address space and let the arena commit pages as we push into it.
+    // Only the pages we actually touch cost us physical memory.
+    memory_arena_t reserved_arena;
+    reserve_arena(&reserved_arena, 1024 * 1024 * 1024);
+    for (size_t i = 0; i < 1024; i++)
+    {
+        char* block = (char*)arena_push(&reserved_arena, 1024);
+        block[0] = (char)i;
+    }
+
+    // Level data and per-frame data can share one region: the level grows up from the
+    // bottom, frame temporaries grow down from the top and are rewound every frame.
+    double_ended_arena_t level_arena;
+    allocate_double_ended_arena(&level_arena, 64 * 1024);
+    int* level_tiles = (int*)double_ended_push_bottom(&level_arena, sizeof(int) * 256);
+    for (int frame = 0; frame < 4; frame++)
+    {
+        double_ended_scope_t frame_scope(&level_arena, DOUBLE_ENDED_TOP);
+        int* visible = (int*)double_ended_push_top(&level_arena, sizeof(int) * 64);
+        for (int i = 0; i < 64; i++)
+            visible[i] = level_tiles[i] = frame + i;
+    }
+    release_double_ended_arena(&level_arena);
+
+    // When lifetimes are all over the place and sizes vary, a TLSF allocator gives us
+    // malloc-style allocate and free with a bounded cost, still living in an arena.
+    memory_arena_t general_arena;
+    reserve_arena(&general_arena, 64 * 1024 * 1024);
+    tlsf_allocator_t general;
+    tlsf_initialize(&general, &general_arena, 1024 * 1024, 1024 * 1024);
+    char* name = (char*)tlsf_alloc(&general, 64);
+    int* scores = (int*)tlsf_alloc(&general, sizeof(int) * 1000);
+    tlsf_free(&general, name);
+    scores[0] = my_area;
+    tlsf_free(&general, scores);
+    release_arena(&general_arena);
+
+    // Streams of variable sized records fit a ring buffer, and with the buffer mapped
+    // twice in a row a record that runs off the end is still one contiguous block.
+    ring_buffer_t stream;
+    allocate_ring_buffer(&stream, 64 * 1024);
+    for (int record = 0; record < 1000; record++)
+    {
+        char message[100];
+        int length = snprintf(message, sizeof(message), "record %d: area %d", record, my_area);
+        ring_buffer_push(&stream, message, (size_t)length + 1);
+
+        size_t available = 0;
+        char* received = (char*)ring_buffer_peek(&stream, &available);
+        ring_buffer_consume(&stream, strlen(received) + 1);
+    }
+    release_ring_buffer(&stream);
+
+    // A simulation loop reads last frame's state while building this frame's. Two
+    // rotating frame buffers keep exactly one old frame alive with no frees at all.
+    frame_allocator_t frames;
+    allocate_frame_allocator(&frames, 2, 64 * 1024 * 1024);
+    int* positions = NULL;
+    for (int frame = 0; frame < 8; frame++)
+    {
+        frame_allocator_begin_frame(&frames);
+        int* previous_positions = positions;
+        positions = (int*)frame_allocator_push(&frames, sizeof(int) * 256);
+        for (int i = 0; i < 256; i++)
+            positions[i] = (previous_positions != NULL) ? previous_positions[i] + 1 : i;
+    }
+    release_frame_allocator(&frames);
+
+    // Output whose length we only learn as we go can grow on top of the arena without
+    // ever being copied, as long as nothing else is pushed in the meantime.
+    arena_vector<int> squares(&reserved_arena);
+    for (int i = 0; i < 10000; i++)
+        squares.push_back(i * i);
+    squares.shrink_to_fit();
+
+    // Zeroed pushes only clear what a previous push may have dirtied; pages the arena
+    // commits for the first time already come zeroed from the OS.
+    int* histogram = (int*)arena_push_zeroed(&reserved_arena, sizeof(int) * 4096);
+    int* histogram_copy = arena_push_array(&reserved_arena, int, 4096);
+    arena_fill(histogram, 0x01, sizeof(int) * 64);
+    arena_copy(histogram_copy, histogram, sizeof(int) * 4096);
+
+    // State that should outlive the process goes in a persistent arena. The next run
+    // maps the file and picks up where this one left off, with nothing to load. The
+    // sample keeps its file in the temp directory rather than wherever it was run from.
+    std::error_code temp_error;
+    std::filesystem::path saved_state_path = std::filesystem::temp_directory_path(temp_error);
+    saved_state_path /= "allocators_sample.arena";
+    persistent_arena_t saved_state;
+    if (!temp_error && open_persistent_arena(&saved_state, saved_state_path.string().c_str(),
+                1024 * 1024, 1) != PERSISTENT_ARENA_FAILED)
+    {
+        uint64_t* run_count = persistent_arena_get_root<uint64_t>(&saved_state);
+        if (run_count == NULL)
+        {
+            run_count = arena_push_struct(&saved_state.arena, uint64_t);
+            *run_count = 0;
+            persistent_arena_set_root(&saved_state, run_count);
+        }
+        (*run_count)++;
+        close_persistent_arena(&saved_state);
+    }
+
+    // Identifiers that show up over and over are interned once; from then on they are
+    // 32-bit handles that compare with a single instruction.
+    string_interner_t identifiers;
+    if (allocate_string_interner(&identifiers, 64 * 1024 * 1024))
+    {
+        string_intern(&identifiers, "position");
+        string_intern(&identifiers, "velocity");
+
+        // The second lookup hands back the same handle without copying the string again.
+        string_intern(&identifiers, "position");
+        release_string_interner(&identifiers);
+    }
+
+    // Small scratch buffers don't need a reservation at all. This one lives on the stack
+    // and only touches the reserved arena if the path turns out to be unusually long.
+    // The path is pushed in one piece so that, if it does spill, all of it moves over.
+    inline_arena<256> path_scratch(&reserved_arena);
+    const char* parts[] = { "assets", "textures", "environment", "sky.png" };
+    size_t path_length = 0;
+    for (const char* part : parts)
+        path_length += strlen(part) + 1;
+
+    char* path = (char*)arena_push(&path_scratch, path_length);
+    if (path != NULL)
+    {
+        size_t offset = 0;
+        for (const char* part : parts)
+        {
+            size_t length = strlen(part);
+            memcpy(path + offset, part, length);
+            path[offset + length] = '/';
+            offset += length + 1;
+        }
+        path[path_length - 1] = '\0';
+    }
+    arena_reset(&path_scratch);
+
+    // Configure with -DALLOCATORS_INSTRUMENTATION=ON to see how full the arenas got.
+#   if ARENA_INSTRUMENTATION
+        arena_statistics_report(&base_arena, "base_arena", stdout);
+        arena_statistics_report(&reserved_arena, "reserved_arena", stdout);
+#   endif
+
+    release_arena(&reserved_arena);
+    release_arena(&base_arena);
+
     return 0;
 }
 
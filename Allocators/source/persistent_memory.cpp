@@ -0,0 +1,281 @@
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+#include <cstring>
+#include "persistent_memory.h"
+
+// FNV-1a; the header is small and this only runs on open and close.
+static uint64_t
+persistent_header_checksum(const persistent_arena_header_t *header)
+{
+
+    const unsigned char* bytes = (const unsigned char*)header;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < offsetof(persistent_arena_header_t, checksum); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+
+}
+
+// Returns NULL if the header describes a file we can use, or the reason we can't. Stale
+// files (another build, another schema, or a crash) can never be used and are flagged
+// as such; for anything else the data may still be worth keeping.
+static const char*
+persistent_header_validate(const persistent_arena_header_t *header, uint64_t file_size,
+        uint64_t data_offset, uint64_t data_capacity, uint32_t user_version, bool *stale)
+{
+
+    *stale = false;
+    if (header->magic != PERSISTENT_ARENA_MAGIC)
+        return "not a persistent arena file";
+
+    *stale = true;
+    if (header->format_version != PERSISTENT_ARENA_FORMAT_VERSION
+            || header->header_size != sizeof(persistent_arena_header_t)
+            || header->pointer_size != sizeof(void*))
+        return "written by an incompatible build";
+    // The root can move while the file is open, so a dirty header's checksum is stale.
+    if (header->clean != 1)
+        return "not closed cleanly";
+
+    *stale = false;
+    if (header->checksum != persistent_header_checksum(header))
+        return "header checksum mismatch";
+
+    *stale = true;
+    if (header->user_version != user_version)
+        return "user version mismatch";
+
+    *stale = false;
+    if (header->data_offset != data_offset || file_size < data_offset
+            || header->commit > file_size - data_offset)
+        return "truncated";
+    if (header->commit > data_capacity)
+        return "larger than the reservation";
+    if (header->root_offset != PERSISTENT_ARENA_NO_ROOT && header->root_offset >= header->commit)
+        return "root outside the arena";
+
+    return NULL;
+
+}
+
+persistent_arena_status
+open_persistent_arena(persistent_arena_t *persistent, const char *path, size_t reserve_size,
+        uint32_t user_version, bool discard_unusable)
+{
+
+    // The header gets a granularity-sized block of its own so the arena that follows
+    // is page aligned, whatever the mapping address.
+    uint64_t data_offset = get_nearest_page_granularity_size(sizeof(persistent_arena_header_t));
+    uint64_t data_capacity = get_nearest_page_granularity_size(reserve_size);
+    uint64_t mapped_size = data_offset + data_capacity;
+
+    persistent->header = NULL;
+    persistent->rejected_reason = NULL;
+    persistent_arena_header_t existing = {};
+    uint64_t file_size = 0;
+    bool have_header = false;
+    char* memory = NULL;
+
+#   if defined(_WIN32)
+        HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return PERSISTENT_ARENA_FAILED;
+
+        LARGE_INTEGER size = {};
+        GetFileSizeEx(file, &size);
+        file_size = (uint64_t)size.QuadPart;
+
+        DWORD bytes_read = 0;
+        if (file_size >= sizeof(existing)
+                && ReadFile(file, &existing, sizeof(existing), &bytes_read, NULL)
+                && bytes_read == sizeof(existing))
+            have_header = true;
+#   elif defined(__linux__)
+        int file = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (file < 0)
+            return PERSISTENT_ARENA_FAILED;
+
+        struct stat status = {};
+        fstat(file, &status);
+        file_size = (uint64_t)status.st_size;
+
+        if (file_size >= sizeof(existing)
+                && pread(file, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing))
+            have_header = true;
+#   endif
+
+    // Only ever overwrite a file that is empty or already one of ours. Anything else
+    // belongs to somebody else, and a typo in the path shouldn't cost them their data.
+    // Our own files are thrown away when they are stale. One that is intact but can't be
+    // used as asked, say reopened with a smaller reservation, is kept unless the caller
+    // says otherwise.
+    bool keep_file = false;
+    if (file_size != 0 && (!have_header || existing.magic != PERSISTENT_ARENA_MAGIC))
+    {
+        persistent->rejected_reason = "not a persistent arena file";
+        keep_file = true;
+    }
+    else if (have_header)
+    {
+        bool stale = false;
+        persistent->rejected_reason = persistent_header_validate(&existing, file_size,
+                data_offset, data_capacity, user_version, &stale);
+        keep_file = (persistent->rejected_reason != NULL && !stale && !discard_unusable);
+    }
+
+    if (keep_file)
+    {
+#       if defined(_WIN32)
+            CloseHandle(file);
+#       elif defined(__linux__)
+            close(file);
+#       endif
+        return PERSISTENT_ARENA_FAILED;
+    }
+
+    bool reuse = (have_header && persistent->rejected_reason == NULL);
+
+    // Throw away an arena we can't use, then size the file to the whole reservation.
+#   if defined(_WIN32)
+        LARGE_INTEGER position = {};
+        if (!reuse)
+        {
+            SetFilePointerEx(file, position, NULL, FILE_BEGIN);
+            SetEndOfFile(file);
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                (DWORD)(mapped_size >> 32), (DWORD)(mapped_size & 0xFFFFFFFF), NULL);
+        if (mapping != NULL)
+            memory = (char*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)mapped_size);
+
+        if (memory == NULL)
+        {
+            if (mapping != NULL) CloseHandle(mapping);
+            CloseHandle(file);
+            return PERSISTENT_ARENA_FAILED;
+        }
+
+        persistent->file = file;
+        persistent->mapping = mapping;
+#   elif defined(__linux__)
+        if ((!reuse && ftruncate(file, 0) != 0) || ftruncate(file, (off_t)mapped_size) != 0)
+        {
+            close(file);
+            return PERSISTENT_ARENA_FAILED;
+        }
+
+        void* mapped = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(file);
+            return PERSISTENT_ARENA_FAILED;
+        }
+
+        memory = (char*)mapped;
+        persistent->file = file;
+#   endif
+
+    persistent_arena_header_t* header = (persistent_arena_header_t*)memory;
+    if (!reuse)
+    {
+        *header = {};
+        header->magic = PERSISTENT_ARENA_MAGIC;
+        header->format_version = PERSISTENT_ARENA_FORMAT_VERSION;
+        header->header_size = sizeof(persistent_arena_header_t);
+        header->user_version = user_version;
+        header->pointer_size = sizeof(void*);
+        header->data_offset = data_offset;
+        header->commit = 0;
+        header->root_offset = PERSISTENT_ARENA_NO_ROOT;
+    }
+
+    // Dirty until closed, so a crash in between leaves a file the next run will reject.
+    header->clean = 0;
+    header->checksum = persistent_header_checksum(header);
+#   if defined(_WIN32)
+        FlushViewOfFile(memory, sizeof(persistent_arena_header_t));
+#   elif defined(__linux__)
+        msync(memory, data_offset, MS_SYNC);
+#   endif
+
+    persistent->header = header;
+    persistent->mapped_size = (size_t)mapped_size;
+
+    memory_arena_t* arena = &persistent->arena;
+    arena->memory_region = memory + data_offset;
+    arena->commit = (size_t)header->commit;
+    arena->capacity = (size_t)data_capacity;
+    arena->reserved = (size_t)data_capacity;
+    arena->checkpoint_depth = 0;
+    arena->page_size = get_nearest_page_granularity_size(1);
+    arena->page_backing = ARENA_BACKING_STANDARD;
+    arena->destructors = NULL;
+    arena->purge = {};
+    ARENA_RECORD_RESET(arena);
+
+    return reuse ? PERSISTENT_ARENA_OPENED : PERSISTENT_ARENA_CREATED;
+
+}
+
+void
+close_persistent_arena(persistent_arena_t *persistent)
+{
+
+    if (persistent->header == NULL)
+        return;
+
+    // Destructor entries hold raw pointers and would be meaningless next run.
+    assert(persistent->arena.destructors == NULL);
+
+    persistent_arena_header_t* header = persistent->header;
+    uint64_t data_offset = header->data_offset;
+    uint64_t used_size = data_offset + get_nearest_page_granularity_size(persistent->arena.commit);
+    char* memory = (char*)header;
+
+    header->commit = persistent->arena.commit;
+
+    // Make sure the data is on disk before the header says it's good.
+#   if defined(_WIN32)
+        FlushViewOfFile(memory + data_offset, (SIZE_T)(used_size - data_offset));
+        header->clean = 1;
+        header->checksum = persistent_header_checksum(header);
+        FlushViewOfFile(memory, sizeof(persistent_arena_header_t));
+
+        UnmapViewOfFile(memory);
+        CloseHandle((HANDLE)persistent->mapping);
+
+        LARGE_INTEGER position = {};
+        position.QuadPart = (LONGLONG)used_size;
+        SetFilePointerEx((HANDLE)persistent->file, position, NULL, FILE_BEGIN);
+        SetEndOfFile((HANDLE)persistent->file);
+        CloseHandle((HANDLE)persistent->file);
+#   elif defined(__linux__)
+        msync(memory + data_offset, used_size - data_offset, MS_SYNC);
+        header->clean = 1;
+        header->checksum = persistent_header_checksum(header);
+        msync(memory, data_offset, MS_SYNC);
+
+        // If trimming fails the file just keeps its full (sparse) size, which is harmless.
+        munmap(memory, persistent->mapped_size);
+        int trimmed = ftruncate(persistent->file, (off_t)used_size);
+        (void)trimmed;
+        close(persistent->file);
+#   endif
+
+    persistent->header = NULL;
+    persistent->arena.memory_region = NULL;
+
+}
+
@@ -0,0 +1,126 @@
+#ifndef CUSTOM_ALLOCATORS_PERSISTENT_MEMORY_H
+#define CUSTOM_ALLOCATORS_PERSISTENT_MEMORY_H
+#include <cstdint>
+#include "custom_memory.h"
+
+// An arena backed by a memory-mapped file. Whatever is pushed onto it is written to the
+// file by the OS as it sees fit, and the next run can map the file and use the data
+// straight away, with no loading or parsing; pages are faulted in as they are touched.
+//
+// The file can be mapped at a different address every run, so structures that live in
+// a persistent arena must not hold raw pointers into it. offset_ptr<T> stores the
+// distance from itself to its target instead, which stays valid wherever the file lands.
+// The same goes for objects with destructors; the destructor list is not persisted.
+//
+// The file starts with a header describing the format, the caller's own version number
+// and how much of the arena is in use. The header is marked dirty while the file is
+// open and clean only by close_persistent_arena(). A file that was not closed cleanly
+// is discarded on the next open: its data may be half written, so the arena starts out
+// empty. The same goes for a file written by a different format, schema version or
+// pointer size. Either way rejected_reason says why.
+//
+// Any other problem fails the open and leaves the file alone, since the data may still
+// be sound: an arena reopened with a smaller reserve_size than it holds, or a damaged
+// header. Passing discard_unusable truncates those files and starts over instead.
+// Files that aren't persistent arenas at all are never touched; opening one fails.
+//
+// The file is sized up to the full reservation while open, which costs nothing on file
+// systems with sparse files, and trimmed back to what is in use when it is closed.
+
+#define PERSISTENT_ARENA_MAGIC 0x414E455241544148ULL  // "HATARENA"
+#define PERSISTENT_ARENA_FORMAT_VERSION 1
+#define PERSISTENT_ARENA_NO_ROOT ((uint64_t)-1)
+
+struct persistent_arena_header_t
+{
+    uint64_t magic;
+    uint32_t format_version;
+    uint32_t header_size;
+    uint32_t user_version;
+    uint32_t pointer_size;
+    uint64_t data_offset;       // Where the arena starts in the file.
+    uint64_t commit;            // Bytes of the arena in use.
+    uint64_t root_offset;       // Offset of the root object within the arena.
+    uint64_t clean;             // Set only while the file is closed.
+    uint64_t checksum;          // Over every field above.
+};
+
+enum persistent_arena_status
+{
+    PERSISTENT_ARENA_FAILED,    // Couldn't map the file, or it can't be used as asked.
+    PERSISTENT_ARENA_CREATED,   // New or discarded file; the arena is empty.
+    PERSISTENT_ARENA_OPENED,    // Valid file; the arena holds what was there last time.
+};
+
+struct persistent_arena_t
+{
+    memory_arena_t arena;
+    persistent_arena_header_t* header;
+    size_t mapped_size;
+    const char* rejected_reason;   // Why an existing file was not used, if it wasn't.
+
+#   if defined(_WIN32)
+        void* file;
+        void* mapping;
+#   else
+        int file;
+#   endif
+};
+
+persistent_arena_status open_persistent_arena(persistent_arena_t *persistent, const char *path,
+            size_t reserve_size, uint32_t user_version, bool discard_unusable = false);
+void   close_persistent_arena(persistent_arena_t *persistent);
+
+// The root is how the next run finds its way into the data.
+inline void
+persistent_arena_set_root(persistent_arena_t *persistent, void *root)
+{
+    persistent->header->root_offset = (root == NULL) ? PERSISTENT_ARENA_NO_ROOT
+        : (uint64_t)((char*)root - (char*)persistent->arena.memory_region);
+}
+
+template <typename T> inline T*
+persistent_arena_get_root(persistent_arena_t *persistent)
+{
+    uint64_t offset = persistent->header->root_offset;
+    if (offset == PERSISTENT_ARENA_NO_ROOT)
+        return NULL;
+    return (T*)((char*)persistent->arena.memory_region + offset);
+}
+
+// A pointer stored as the signed distance from itself to its target, so it survives the
+// memory it lives in being mapped somewhere else. Copying one recomputes the distance
+// from its new location. Zero is null, so an offset_ptr can't point at itself.
+template <typename T>
+struct offset_ptr
+{
+
+    int64_t offset;
+
+    offset_ptr() : offset(0) { }
+    offset_ptr(T* pointer) { set(pointer); }
+    offset_ptr(const offset_ptr& other) { set(other.get()); }
+
+    offset_ptr& operator=(const offset_ptr& other) { set(other.get()); return *this; }
+    offset_ptr& operator=(T* pointer) { set(pointer); return *this; }
+
+    T*
+    get() const
+    {
+        return (offset == 0) ? NULL : (T*)((char*)this + offset);
+    }
+
+    void
+    set(T* pointer)
+    {
+        offset = (pointer == NULL) ? 0 : (int64_t)((char*)pointer - (char*)this);
+    }
+
+    T* operator->() const { return get(); }
+    T& operator*() const { return *get(); }
+    T& operator[](size_t index) const { return get()[index]; }
+    explicit operator bool() const { return offset != 0; }
+
+};
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef CUSTOM_ALLOCATORS_POOL_ALLOCATOR_H
+#define CUSTOM_ALLOCATORS_POOL_ALLOCATOR_H
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include "custom_memory.h"
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+// A pool hands out fixed-size slots for one type. Slots are carved from the arena in
+// blocks; each block is a contiguous run of slots plus a bitmask of which slots are
+// live. Freed slots go on an intrusive free list (the "next" pointer lives inside the
+// dead slot), so allocating and freeing are both O(1) and objects can die in any order.
+//
+// Blocks are aligned to their own size, which lets us find a slot's block by masking
+// the pointer. The first block pushed onto an arena may pay some padding for this;
+// consecutive blocks on an otherwise unused arena pack perfectly.
+#ifndef POOL_BLOCK_SIZE
+#   define POOL_BLOCK_SIZE (16 * 1024)
+#endif
+
+template <typename T>
+union pool_slot_t
+{
+    pool_slot_t* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+};
+
+template <typename T>
+struct pool_layout_t
+{
+
+    static constexpr size_t slot_size = sizeof(pool_slot_t<T>);
+    static constexpr size_t slot_alignment = alignof(pool_slot_t<T>);
+
+    // Blocks are at least POOL_BLOCK_SIZE and double until a reasonable number of
+    // slots fit, so very large types still get a few per block.
+    static constexpr size_t
+    compute_block_size()
+    {
+        size_t block_size = POOL_BLOCK_SIZE;
+        while (block_size < slot_size * 16 + 1024)
+            block_size *= 2;
+        return block_size;
+    }
+
+    static constexpr size_t block_size = compute_block_size();
+    static constexpr size_t mask_words = (block_size / slot_size + 63) / 64;
+    static constexpr size_t header_size = sizeof(void*) + mask_words * sizeof(uint64_t);
+    static constexpr size_t slots_offset =
+        (header_size + slot_alignment - 1) & ~(slot_alignment - 1);
+    static constexpr size_t slots_per_block = (block_size - slots_offset) / slot_size;
+
+    static_assert((block_size & (block_size - 1)) == 0, "Pool blocks must be a power of two.");
+    static_assert(slots_per_block > 0, "Pool blocks must hold at least one slot.");
+
+};
+
+template <typename T>
+struct pool_block_t
+{
+    pool_block_t* next;
+    uint64_t live_mask[pool_layout_t<T>::mask_words];
+};
+
+template <typename T>
+struct object_pool_t
+{
+    memory_arena_t* arena;
+    pool_block_t<T>* first_block;
+    pool_block_t<T>* last_block;
+    pool_block_t<T>* carve_block;
+    size_t carve_index;
+    pool_slot_t<T>* free_list;
+    size_t live_count;
+};
+
+inline uint32_t
+pool_count_trailing_zeros(uint64_t value)
+{
+#   if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return (uint32_t)index;
+#   else
+        return (uint32_t)__builtin_ctzll(value);
+#   endif
+}
+
+template <typename T> inline pool_slot_t<T>*
+pool_block_slots(pool_block_t<T> *block)
+{
+    return (pool_slot_t<T>*)(((char*)block) + pool_layout_t<T>::slots_offset);
+}
+
+template <typename T> inline pool_block_t<T>*
+pool_block_from_slot(void *slot)
+{
+    size_t mask = ~(pool_layout_t<T>::block_size - 1);
+    return (pool_block_t<T>*)(((size_t)slot) & mask);
+}
+
+template <typename T> inline void
+pool_initialize(object_pool_t<T> *pool, memory_arena_t *arena)
+{
+    *pool = {};
+    pool->arena = arena;
+}
+
+// Pushes a fresh block onto the arena and makes it the block we carve from.
+template <typename T> bool
+pool_push_block(object_pool_t<T> *pool)
+{
+
+    typedef pool_layout_t<T> layout;
+    static_assert(sizeof(pool_block_t<T>) <= layout::slots_offset, "Block header overlaps slots.");
+
+    pool_block_t<T>* block = (pool_block_t<T>*)arena_push_aligned(pool->arena,
+            layout::block_size, layout::block_size);
+    if (block == NULL)
+        return false;
+
+    block->next = NULL;
+    for (size_t i = 0; i < layout::mask_words; i++)
+        block->live_mask[i] = 0;
+
+    if (pool->last_block != NULL)
+        pool->last_block->next = block;
+    else
+        pool->first_block = block;
+    pool->last_block = block;
+
+    pool->carve_block = block;
+    pool->carve_index = 0;
+    return true;
+
+}
+
+// Returns an uninitialized slot. Recycled slots come first so that the working set
+// stays small, otherwise we carve the next untouched slot from the current block.
+template <typename T> inline T*
+pool_alloc(object_pool_t<T> *pool)
+{
+
+    typedef pool_layout_t<T> layout;
+
+    pool_slot_t<T>* slot = pool->free_list;
+    if (slot != NULL)
+    {
+        pool->free_list = slot->next;
+    }
+    else
+    {
+        if (pool->carve_block == NULL || pool->carve_index == layout::slots_per_block)
+        {
+            // After a reset the old blocks are still around; reuse them before
+            // asking the arena for more.
+            if (pool->carve_block != NULL && pool->carve_block->next != NULL)
+            {
+                pool->carve_block = pool->carve_block->next;
+                pool->carve_index = 0;
+            }
+            else if (!pool_push_block(pool))
+            {
+                return NULL;
+            }
+        }
+
+        slot = pool_block_slots(pool->carve_block) + pool->carve_index;
+        pool->carve_index++;
+    }
+
+    pool_block_t<T>* block = pool_block_from_slot<T>(slot);
+    size_t index = (size_t)(slot - pool_block_slots(block));
+    block->live_mask[index / 64] |= (1ULL << (index % 64));
+    pool->live_count++;
+
+    return (T*)slot->storage;
+
+}
+
+template <typename T> inline void
+pool_free(object_pool_t<T> *pool, T *object)
+{
+
+    pool_slot_t<T>* slot = (pool_slot_t<T>*)object;
+    pool_block_t<T>* block = pool_block_from_slot<T>(slot);
+    size_t index = (size_t)(slot - pool_block_slots(block));
+
+    assert((block->live_mask[index / 64] & (1ULL << (index % 64))) != 0);
+    block->live_mask[index / 64] &= ~(1ULL << (index % 64));
+
+    slot->next = pool->free_list;
+    pool->free_list = slot;
+    pool->live_count--;
+
+}
+
+// Typed versions of the above that run the constructor and destructor for us.
+template <typename T, typename... Args> inline T*
+pool_create(object_pool_t<T> *pool, Args&&... args)
+{
+    T* object = pool_alloc(pool);
+    if (object == NULL)
+        return NULL;
+    return ::new ((void*)object) T(static_cast<Args&&>(args)...);
+}
+
+template <typename T> inline void
+pool_destroy(object_pool_t<T> *pool, T *object)
+{
+    object->~T();
+    pool_free(pool, object);
+}
+
+// Visits every live object, block by block and in address order within a block.
+// The callback must not allocate from or free into the pool.
+template <typename T, typename Callback> void
+pool_for_each(object_pool_t<T> *pool, Callback callback)
+{
+
+    typedef pool_layout_t<T> layout;
+
+    for (pool_block_t<T>* block = pool->first_block; block != NULL; block = block->next)
+    {
+        pool_slot_t<T>* slots = pool_block_slots(block);
+        for (size_t word = 0; word < layout::mask_words; word++)
+        {
+            uint64_t mask = block->live_mask[word];
+            while (mask != 0)
+            {
+                size_t index = word * 64 + pool_count_trailing_zeros(mask);
+                callback(*(T*)slots[index].storage);
+                mask &= mask - 1;
+            }
+        }
+    }
+
+}
+
+// Destroys every live object and makes every slot available again. The blocks stay
+// with the pool; the memory only goes back when the arena itself is rewound.
+template <typename T> void
+pool_reset(object_pool_t<T> *pool)
+{
+
+    if (!std::is_trivially_destructible<T>::value)
+        pool_for_each(pool, [](T& object) { object.~T(); });
+
+    for (pool_block_t<T>* block = pool->first_block; block != NULL; block = block->next)
+    {
+        for (size_t i = 0; i < pool_layout_t<T>::mask_words; i++)
+            block->live_mask[i] = 0;
+    }
+
+    pool->carve_block = pool->first_block;
+    pool->carve_index = 0;
+    pool->free_list = NULL;
+    pool->live_count = 0;
+
+}
+
+#endif
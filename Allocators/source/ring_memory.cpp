@@ -0,0 +1,113 @@
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+#include "ring_memory.h"
+
+#if defined(_WIN32)
+#   define RING_BUFFER_MAP_ATTEMPTS 16
+#endif
+
+bool
+allocate_ring_buffer(ring_buffer_t *ring, size_t request_size)
+{
+
+    size_t size = get_nearest_page_granularity_size(request_size);
+    char* memory = NULL;
+
+#   if defined(_WIN32)
+        HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+        if (mapping == NULL)
+            return false;
+
+        // Find a free range twice the size, give it back, and map both views into it.
+        // Another thread can take the range in between, so try a few times.
+        for (int attempt = 0; attempt < RING_BUFFER_MAP_ATTEMPTS && memory == NULL; attempt++)
+        {
+            char* range = (char*)VirtualAlloc(NULL, 2 * size, MEM_RESERVE, PAGE_NOACCESS);
+            if (range == NULL)
+                break;
+            VirtualFree(range, 0, MEM_RELEASE);
+
+            void* first = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, range);
+            void* second = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size,
+                    range + size);
+            if (first == range && second == range + size)
+            {
+                memory = range;
+                break;
+            }
+
+            if (first != NULL) UnmapViewOfFile(first);
+            if (second != NULL) UnmapViewOfFile(second);
+        }
+
+        // The views keep the mapping alive on their own.
+        CloseHandle(mapping);
+        if (memory == NULL)
+            return false;
+#   elif defined(__linux__)
+        int file = memfd_create("ring_buffer", MFD_CLOEXEC);
+        if (file < 0)
+            return false;
+
+        if (ftruncate(file, (off_t)size) != 0)
+        {
+            close(file);
+            return false;
+        }
+
+        // Reserve the full range first so nothing else can land in the second half.
+        void* range = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (range == MAP_FAILED)
+        {
+            close(file);
+            return false;
+        }
+
+        memory = (char*)range;
+        void* first = mmap(memory, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                file, 0);
+        void* second = mmap(memory + size, size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, file, 0);
+
+        // The mappings keep the file alive on their own.
+        close(file);
+        if (first == MAP_FAILED || second == MAP_FAILED)
+        {
+            munmap(range, 2 * size);
+            return false;
+        }
+#   endif
+
+    ring->memory = memory;
+    ring->size = size;
+    ring->write_offset.store(0, std::memory_order_relaxed);
+    ring->read_offset.store(0, std::memory_order_relaxed);
+
+    return true;
+
+}
+
+void
+release_ring_buffer(ring_buffer_t *ring)
+{
+
+    if (ring->memory == NULL)
+        return;
+
+#   if defined(_WIN32)
+        UnmapViewOfFile(ring->memory);
+        UnmapViewOfFile(ring->memory + ring->size);
+#   elif defined(__linux__)
+        munmap(ring->memory, 2 * ring->size);
+#   endif
+
+    ring->memory = NULL;
+    ring->size = 0;
+
+}
+
@@ -0,0 +1,97 @@
+#ifndef CUSTOM_ALLOCATORS_RING_MEMORY_H
+#define CUSTOM_ALLOCATORS_RING_MEMORY_H
+#include <atomic>
+#include <cstring>
+#include "custom_memory.h"
+
+// A ring buffer whose memory is mapped twice, back to back, so the byte after the end
+// of the buffer is the first byte of the buffer again. Anything up to the size of the
+// buffer is contiguous in virtual memory no matter where it starts, so records that
+// wrap around the end can be written and read in place without being split or copied.
+//
+// One producer and one consumer may use the buffer from different threads at once. The
+// producer reserves space, writes into it and commits it; the consumer peeks at what is
+// committed and consumes what it has finished with. The size is rounded up to the
+// allocation granularity, since that is the unit both mappings must be placed at.
+
+#define RING_BUFFER_CACHE_LINE 64
+
+struct ring_buffer_t
+{
+
+    char* memory;
+    size_t size;
+
+    // Both offsets only ever increase; the position in the buffer is offset % size.
+    alignas(RING_BUFFER_CACHE_LINE) std::atomic<size_t> write_offset;
+    alignas(RING_BUFFER_CACHE_LINE) std::atomic<size_t> read_offset;
+    char read_padding[RING_BUFFER_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+};
+
+bool   allocate_ring_buffer(ring_buffer_t *ring, size_t request_size);
+void   release_ring_buffer(ring_buffer_t *ring);
+
+// Producer side. Returns NULL if there isn't room for size bytes right now.
+inline void*
+ring_buffer_reserve(ring_buffer_t *ring, size_t size)
+{
+
+    size_t write = ring->write_offset.load(std::memory_order_relaxed);
+    size_t read = ring->read_offset.load(std::memory_order_acquire);
+    if (size > ring->size - (write - read))
+        return NULL;
+
+    return ring->memory + (write % ring->size);
+
+}
+
+// Publishes size bytes written through the last reservation to the consumer.
+inline void
+ring_buffer_commit(ring_buffer_t *ring, size_t size)
+{
+    size_t write = ring->write_offset.load(std::memory_order_relaxed);
+    ring->write_offset.store(write + size, std::memory_order_release);
+}
+
+inline bool
+ring_buffer_push(ring_buffer_t *ring, const void *data, size_t size)
+{
+
+    void* destination = ring_buffer_reserve(ring, size);
+    if (destination == NULL)
+        return false;
+
+    memcpy(destination, data, size);
+    ring_buffer_commit(ring, size);
+    return true;
+
+}
+
+// Consumer side. Returns the start of the committed data and how much of it there is,
+// or NULL when the buffer is empty.
+inline void*
+ring_buffer_peek(ring_buffer_t *ring, size_t *available)
+{
+
+    size_t read = ring->read_offset.load(std::memory_order_relaxed);
+    size_t write = ring->write_offset.load(std::memory_order_acquire);
+    *available = write - read;
+    if (*available == 0)
+        return NULL;
+
+    return ring->memory + (read % ring->size);
+
+}
+
+inline void
+ring_buffer_consume(ring_buffer_t *ring, size_t size)
+{
+
+    size_t read = ring->read_offset.load(std::memory_order_relaxed);
+    assert(size <= ring->write_offset.load(std::memory_order_acquire) - read);
+    ring->read_offset.store(read + size, std::memory_order_release);
+
+}
+
+#endif
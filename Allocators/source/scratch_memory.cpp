@@ -0,0 +1,70 @@
+#include "scratch_memory.h"
+
+// The per-thread scratch arenas. The destructor runs at thread exit and gives the
+// reservations back to the OS.
+struct scratch_thread_context_t
+{
+
+    ~scratch_thread_context_t()
+    {
+        for (size_t i = 0; i < SCRATCH_ARENA_COUNT; i++)
+            release_arena(&arenas[i]);
+    }
+
+    memory_arena_t arenas[SCRATCH_ARENA_COUNT];
+    bool initialized;
+
+};
+
+static thread_local scratch_thread_context_t scratch_context = {};
+
+static bool
+initialize_scratch_context(scratch_thread_context_t *context)
+{
+
+    for (size_t i = 0; i < SCRATCH_ARENA_COUNT; i++)
+    {
+        if (!reserve_arena(&context->arenas[i], SCRATCH_ARENA_RESERVE_SIZE))
+        {
+            // Give back what we did get; the next call starts over from scratch.
+            for (size_t j = 0; j < i; j++)
+                release_arena(&context->arenas[j]);
+            return false;
+        }
+    }
+
+    context->initialized = true;
+    return true;
+
+}
+
+memory_arena_t*
+get_scratch_arena(memory_arena_t **conflicts, size_t conflict_count)
+{
+
+    scratch_thread_context_t* context = &scratch_context;
+    if (!context->initialized && !initialize_scratch_context(context))
+        return NULL;
+
+    for (size_t i = 0; i < SCRATCH_ARENA_COUNT; i++)
+    {
+        memory_arena_t* candidate = &context->arenas[i];
+
+        bool has_conflict = false;
+        for (size_t j = 0; j < conflict_count; j++)
+        {
+            if (conflicts[j] == candidate)
+            {
+                has_conflict = true;
+                break;
+            }
+        }
+
+        if (!has_conflict)
+            return candidate;
+    }
+
+    return NULL;
+
+}
+
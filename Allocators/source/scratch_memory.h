@@ -0,0 +1,59 @@
+#ifndef CUSTOM_ALLOCATORS_SCRATCH_MEMORY_H
+#define CUSTOM_ALLOCATORS_SCRATCH_MEMORY_H
+#include "custom_memory.h"
+
+// Each thread owns a small set of scratch arenas. They are reserved the first time
+// the thread asks for one and released when the thread exits, so handing out scratch
+// memory afterwards never touches malloc or the OS.
+#ifndef SCRATCH_ARENA_COUNT
+#   define SCRATCH_ARENA_COUNT 2
+#endif
+
+#ifndef SCRATCH_ARENA_RESERVE_SIZE
+#   define SCRATCH_ARENA_RESERVE_SIZE (64 * 1024 * 1024)
+#endif
+
+// Returns one of the calling thread's scratch arenas that is not in the conflicts
+// list. A function that pushes its results onto a caller-provided arena passes that
+// arena in as a conflict; if the caller's arena happens to be a scratch arena itself,
+// we hand back the other one so the function's temporaries never get interleaved
+// with (or rewound over) the results. Returns NULL if every arena conflicts.
+memory_arena_t* get_scratch_arena(memory_arena_t **conflicts, size_t conflict_count);
+
+// Grabs a non-conflicting scratch arena and rewinds it when the scope ends. If there is
+// no arena to hand out, the scope is empty: arena is NULL and nothing gets rewound, so
+// callers need to check it before pushing.
+struct scratch_scope_t
+{
+
+    scratch_scope_t(memory_arena_t *conflict = NULL)
+    {
+        arena = get_scratch_arena(&conflict, (conflict != NULL) ? 1 : 0);
+        checkpoint = {};
+        if (arena != NULL)
+            checkpoint = arena_checkpoint(arena);
+    }
+
+    scratch_scope_t(memory_arena_t **conflicts, size_t conflict_count)
+    {
+        arena = get_scratch_arena(conflicts, conflict_count);
+        checkpoint = {};
+        if (arena != NULL)
+            checkpoint = arena_checkpoint(arena);
+    }
+
+    ~scratch_scope_t()
+    {
+        if (arena != NULL)
+            arena_restore(checkpoint);
+    }
+
+    scratch_scope_t(const scratch_scope_t&) = delete;
+    scratch_scope_t& operator=(const scratch_scope_t&) = delete;
+
+    memory_arena_t* arena;
+    arena_checkpoint_t checkpoint;
+
+};
+
+#endif
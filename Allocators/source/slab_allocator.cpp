@@ -0,0 +1,470 @@
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include "custom_memory.h"
+#include "slab_allocator.h"
+
+#ifndef SLAB_ALLOCATOR_REPLACE_MALLOC
+#   define SLAB_ALLOCATOR_REPLACE_MALLOC 0
+#endif
+
+// Sixteen byte steps up to 128 bytes, then four classes per power of two up to
+// SLAB_MAX_SIZE, so no class wastes more than a fifth of an object to rounding.
+#define SLAB_SMALL_CLASS_COUNT 8
+#define SLAB_SMALL_CLASS_LIMIT 128
+#define SLAB_CLASS_COUNT 40
+#define SLAB_SPAN_HEADER_SIZE 64
+
+#define SLAB_BATCH_MIN 4
+#define SLAB_BATCH_MAX 256
+
+struct slab_span_t
+{
+    uint32_t size_class;
+    uint32_t object_size;
+};
+
+// Free objects are linked through their first word. The first object of a batch sitting
+// in a central pool links to the next batch through its second.
+struct slab_object_t
+{
+    slab_object_t* next;
+    slab_object_t* next_batch;
+};
+
+struct slab_central_t
+{
+    std::mutex lock;
+    slab_object_t* batches = NULL;
+
+    // Partial batches handed back by exiting threads.
+    slab_object_t* loose = NULL;
+    size_t loose_count = 0;
+};
+
+// Everything has a default initializer so the heap is constant-initialized; when we
+// replace malloc we may be called before any static constructors have run.
+struct slab_heap_t
+{
+    std::mutex lock;
+    bool initialized = false;
+    memory_arena_t arena = {};
+
+    // Written once when the reservation is made. Pointers inside this range are small
+    // objects, anything else passed to slab_free is a large allocation.
+    std::atomic<char*> base = { NULL };
+    std::atomic<char*> end = { NULL };
+
+    slab_central_t central[SLAB_CLASS_COUNT];
+};
+
+struct slab_thread_cache_t
+{
+    ~slab_thread_cache_t();
+
+    slab_object_t* free_lists[SLAB_CLASS_COUNT];
+    uint32_t counts[SLAB_CLASS_COUNT];
+};
+
+// Large allocations remember the arena they came from just in front of the pointer.
+struct slab_large_t
+{
+    memory_arena_t arena;
+    size_t size;
+};
+
+static slab_heap_t slab_heap;
+static thread_local slab_thread_cache_t slab_cache = {};
+
+static inline int
+slab_fls(size_t value)
+{
+#   if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, (unsigned long long)value);
+        return (int)index;
+#   else
+        return 63 - __builtin_clzll((unsigned long long)value);
+#   endif
+}
+
+static inline size_t
+slab_size_class(size_t size)
+{
+
+    if (size <= SLAB_SMALL_CLASS_LIMIT)
+        return (size == 0) ? 0 : (size - 1) / 16;
+
+    // size is in (2^bit, 2^(bit + 1)], split into four steps.
+    int bit = slab_fls(size - 1);
+    size_t step = (size - 1 - ((size_t)1 << bit)) >> (bit - 2);
+    return SLAB_SMALL_CLASS_COUNT + (size_t)(bit - 7) * 4 + step;
+
+}
+
+static inline size_t
+slab_class_size(size_t size_class)
+{
+
+    if (size_class < SLAB_SMALL_CLASS_COUNT)
+        return (size_class + 1) * 16;
+
+    size_t bit = 7 + (size_class - SLAB_SMALL_CLASS_COUNT) / 4;
+    size_t step = (size_class - SLAB_SMALL_CLASS_COUNT) % 4;
+    return ((size_t)1 << bit) + (step + 1) * ((size_t)1 << (bit - 2));
+
+}
+
+static inline size_t
+slab_batch_count(size_t size_class)
+{
+
+    size_t count = SLAB_BATCH_BYTES / slab_class_size(size_class);
+    if (count < SLAB_BATCH_MIN) count = SLAB_BATCH_MIN;
+    if (count > SLAB_BATCH_MAX) count = SLAB_BATCH_MAX;
+    return count;
+
+}
+
+static inline bool
+slab_is_small(void *pointer)
+{
+    char* address = (char*)pointer;
+    return address >= slab_heap.base.load(std::memory_order_relaxed)
+        && address < slab_heap.end.load(std::memory_order_relaxed);
+}
+
+static inline slab_span_t*
+slab_get_span(void *pointer)
+{
+    return (slab_span_t*)((size_t)pointer & ~((size_t)SLAB_SPAN_SIZE - 1));
+}
+
+// Carves a fresh span into a list of objects of one class.
+static slab_object_t*
+slab_new_span(size_t size_class, size_t *count)
+{
+
+    slab_span_t* span = NULL;
+    {
+        std::lock_guard<std::mutex> guard(slab_heap.lock);
+        if (!slab_heap.initialized)
+        {
+            if (!reserve_arena(&slab_heap.arena, SLAB_HEAP_RESERVE_SIZE))
+                return NULL;
+
+            char* base = (char*)slab_heap.arena.memory_region;
+            slab_heap.base.store(base, std::memory_order_relaxed);
+            slab_heap.end.store(base + slab_heap.arena.reserved, std::memory_order_relaxed);
+            slab_heap.initialized = true;
+        }
+
+        span = (slab_span_t*)arena_push_aligned(&slab_heap.arena, SLAB_SPAN_SIZE, SLAB_SPAN_SIZE);
+    }
+
+    if (span == NULL)
+        return NULL;
+
+    size_t object_size = slab_class_size(size_class);
+    span->size_class = (uint32_t)size_class;
+    span->object_size = (uint32_t)object_size;
+
+    char* objects = ((char*)span) + SLAB_SPAN_HEADER_SIZE;
+    size_t object_count = (SLAB_SPAN_SIZE - SLAB_SPAN_HEADER_SIZE) / object_size;
+    for (size_t i = 0; i < object_count - 1; i++)
+        ((slab_object_t*)(objects + i * object_size))->next =
+            (slab_object_t*)(objects + (i + 1) * object_size);
+    ((slab_object_t*)(objects + (object_count - 1) * object_size))->next = NULL;
+
+    *count = object_count;
+    return (slab_object_t*)objects;
+
+}
+
+// The slow half of slab_malloc: the thread's list for this class is empty.
+static void*
+slab_refill(slab_thread_cache_t *cache, size_t size_class)
+{
+
+    slab_central_t* central = &slab_heap.central[size_class];
+    slab_object_t* objects = NULL;
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> guard(central->lock);
+        if (central->batches != NULL)
+        {
+            objects = central->batches;
+            central->batches = objects->next_batch;
+            count = slab_batch_count(size_class);
+        }
+        else if (central->loose != NULL)
+        {
+            objects = central->loose;
+            count = central->loose_count;
+            central->loose = NULL;
+            central->loose_count = 0;
+        }
+    }
+
+    if (objects == NULL)
+        objects = slab_new_span(size_class, &count);
+    if (objects == NULL)
+        return NULL;
+
+    cache->free_lists[size_class] = objects->next;
+    cache->counts[size_class] = (uint32_t)(count - 1);
+    return objects;
+
+}
+
+// Moves one batch from the front of the thread's list to the central pool.
+static void
+slab_release_batch(slab_thread_cache_t *cache, size_t size_class)
+{
+
+    size_t batch_count = slab_batch_count(size_class);
+    slab_object_t* head = cache->free_lists[size_class];
+    slab_object_t* tail = head;
+    for (size_t i = 1; i < batch_count; i++)
+        tail = tail->next;
+
+    cache->free_lists[size_class] = tail->next;
+    cache->counts[size_class] -= (uint32_t)batch_count;
+    tail->next = NULL;
+
+    slab_central_t* central = &slab_heap.central[size_class];
+    std::lock_guard<std::mutex> guard(central->lock);
+    head->next_batch = central->batches;
+    central->batches = head;
+
+}
+
+// Hands everything back to the central pools when the thread exits, so objects freed
+// by short-lived consumer threads aren't lost.
+slab_thread_cache_t::
+~slab_thread_cache_t()
+{
+
+    for (size_t size_class = 0; size_class < SLAB_CLASS_COUNT; size_class++)
+    {
+        size_t batch_count = slab_batch_count(size_class);
+        while (counts[size_class] >= batch_count)
+            slab_release_batch(this, size_class);
+
+        slab_object_t* remaining = free_lists[size_class];
+        if (remaining == NULL)
+            continue;
+
+        slab_object_t* tail = remaining;
+        while (tail->next != NULL)
+            tail = tail->next;
+
+        slab_central_t* central = &slab_heap.central[size_class];
+        std::lock_guard<std::mutex> guard(central->lock);
+        tail->next = central->loose;
+        central->loose = remaining;
+        central->loose_count += counts[size_class];
+
+        free_lists[size_class] = NULL;
+        counts[size_class] = 0;
+    }
+
+}
+
+static void*
+slab_large_alloc(size_t size, size_t alignment)
+{
+
+    size_t header_size = sizeof(slab_large_t) + sizeof(slab_large_t*);
+    if (size > (size_t)-1 - header_size - alignment)
+        return NULL;
+
+    memory_arena_t arena;
+    if (!allocate_arena(&arena, header_size + alignment + size))
+        return NULL;
+
+    slab_large_t* large = (slab_large_t*)arena.memory_region;
+    size_t address = ((size_t)large) + header_size;
+    address = (address + alignment - 1) & ~(alignment - 1);
+
+    large->arena = arena;
+    large->size = size;
+    ((slab_large_t**)address)[-1] = large;
+    return (void*)address;
+
+}
+
+static void
+slab_large_free(void *pointer)
+{
+    // The arena lives inside the memory it's about to release, so take a copy.
+    slab_large_t* large = ((slab_large_t**)pointer)[-1];
+    memory_arena_t arena = large->arena;
+    release_arena(&arena);
+}
+
+void*
+slab_malloc(size_t size)
+{
+
+    if (size > SLAB_MAX_SIZE)
+        return slab_large_alloc(size, SLAB_ALIGNMENT);
+
+    size_t size_class = slab_size_class(size);
+    slab_thread_cache_t* cache = &slab_cache;
+    slab_object_t* object = cache->free_lists[size_class];
+    if (object == NULL)
+        return slab_refill(cache, size_class);
+
+    cache->free_lists[size_class] = object->next;
+    cache->counts[size_class]--;
+    return object;
+
+}
+
+void
+slab_free(void *pointer)
+{
+
+    if (pointer == NULL)
+        return;
+
+    if (!slab_is_small(pointer))
+    {
+        slab_large_free(pointer);
+        return;
+    }
+
+    size_t size_class = slab_get_span(pointer)->size_class;
+    slab_thread_cache_t* cache = &slab_cache;
+    slab_object_t* object = (slab_object_t*)pointer;
+    object->next = cache->free_lists[size_class];
+    cache->free_lists[size_class] = object;
+    if (++cache->counts[size_class] > 2 * slab_batch_count(size_class))
+        slab_release_batch(cache, size_class);
+
+}
+
+void*
+slab_calloc(size_t count, size_t size)
+{
+
+    if (size != 0 && count > (size_t)-1 / size)
+        return NULL;
+
+    void* result = slab_malloc(count * size);
+    if (result != NULL)
+        memset(result, 0, count * size);
+    return result;
+
+}
+
+size_t
+slab_usable_size(void *pointer)
+{
+
+    if (pointer == NULL)
+        return 0;
+
+    if (slab_is_small(pointer))
+        return slab_get_span(pointer)->object_size;
+    return (((slab_large_t**)pointer)[-1])->size;
+
+}
+
+void*
+slab_realloc(void *pointer, size_t size)
+{
+
+    if (pointer == NULL)
+        return slab_malloc(size);
+
+    if (size == 0)
+    {
+        slab_free(pointer);
+        return NULL;
+    }
+
+    // Stay put unless the block would end up less than half used.
+    size_t usable_size = slab_usable_size(pointer);
+    if (size <= usable_size && size >= usable_size / 2)
+        return pointer;
+
+    void* result = slab_malloc(size);
+    if (result == NULL)
+        return NULL;
+
+    memcpy(result, pointer, (size < usable_size) ? size : usable_size);
+    slab_free(pointer);
+    return result;
+
+}
+
+void*
+slab_aligned_alloc(size_t alignment, size_t size)
+{
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (alignment <= SLAB_ALIGNMENT)
+        return slab_malloc(size);
+
+    // Objects start a multiple of their size past a span header, so a class whose size
+    // is a multiple of the alignment hands out aligned objects by construction.
+    if (alignment <= SLAB_SPAN_HEADER_SIZE && size <= SLAB_MAX_SIZE)
+    {
+        size_t rounded = (size + alignment - 1) & ~(alignment - 1);
+        if (rounded <= SLAB_MAX_SIZE && slab_class_size(slab_size_class(rounded)) % alignment == 0)
+            return slab_malloc(rounded);
+    }
+
+    return slab_large_alloc(size, alignment);
+
+}
+
+int
+slab_posix_memalign(void **result, size_t alignment, size_t size)
+{
+
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+
+    void* pointer = slab_aligned_alloc(alignment, size);
+    if (pointer == NULL)
+        return ENOMEM;
+
+    *result = pointer;
+    return 0;
+
+}
+
+#if SLAB_ALLOCATOR_REPLACE_MALLOC && defined(__linux__)
+
+extern "C"
+{
+
+void* malloc(size_t size) noexcept { return slab_malloc(size); }
+void free(void* pointer) noexcept { slab_free(pointer); }
+void* calloc(size_t count, size_t size) noexcept { return slab_calloc(count, size); }
+void* realloc(void* pointer, size_t size) noexcept { return slab_realloc(pointer, size); }
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{ return slab_aligned_alloc(alignment, size); }
+void* memalign(size_t alignment, size_t size) noexcept
+{ return slab_aligned_alloc(alignment, size); }
+int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+{ return slab_posix_memalign(result, alignment, size); }
+size_t malloc_usable_size(void* pointer) noexcept { return slab_usable_size(pointer); }
+
+}
+
+#endif
+
@@ -0,0 +1,52 @@
+#ifndef CUSTOM_ALLOCATORS_SLAB_ALLOCATOR_H
+#define CUSTOM_ALLOCATORS_SLAB_ALLOCATOR_H
+#include <cstddef>
+
+// A general purpose allocator for small objects churning across threads, with the same
+// interface as malloc(). Sizes up to SLAB_MAX_SIZE are rounded up to one of a few dozen
+// size classes; each class is carved out of SLAB_SPAN_SIZE spans pushed off one large
+// reserved memory_arena_t, and anything bigger gets an allocate_arena of its own.
+//
+// Every thread keeps a free list per size class and allocates from and frees to it with
+// no locks or atomics at all. When a thread's list runs dry it takes a whole batch of
+// objects from the class's central pool in one go, and when it has too many (say, it
+// is the consumer that frees everything a producer thread allocates) it hands a batch
+// back. The central pools are the only place locks are taken, and only once per batch.
+//
+// Span memory is never returned to the OS; it's recycled through the free lists. Large
+// allocations are unmapped as soon as they are freed.
+//
+// Define SLAB_ALLOCATOR_REPLACE_MALLOC to 1 when compiling slab_allocator.cpp to also
+// export malloc(), free() and friends, which is how the slab_malloc shared library on
+// Linux is built for use with LD_PRELOAD.
+
+#ifndef SLAB_SPAN_SIZE
+#   define SLAB_SPAN_SIZE (256 * 1024)
+#endif
+
+#ifndef SLAB_HEAP_RESERVE_SIZE
+#   define SLAB_HEAP_RESERVE_SIZE ((size_t)16 * 1024 * 1024 * 1024)
+#endif
+
+// Target size in bytes of the batches moved between thread caches and the central pools.
+#ifndef SLAB_BATCH_BYTES
+#   define SLAB_BATCH_BYTES (16 * 1024)
+#endif
+
+#define SLAB_MAX_SIZE (32 * 1024)
+#define SLAB_ALIGNMENT 16
+
+extern "C"
+{
+
+void*  slab_malloc(size_t size);
+void   slab_free(void *pointer);
+void*  slab_calloc(size_t count, size_t size);
+void*  slab_realloc(void *pointer, size_t size);
+void*  slab_aligned_alloc(size_t alignment, size_t size);
+int    slab_posix_memalign(void **result, size_t alignment, size_t size);
+size_t slab_usable_size(void *pointer);
+
+}
+
+#endif
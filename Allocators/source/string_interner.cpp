@@ -0,0 +1,304 @@
+#include <cstdint>
+#include <cstring>
+#include "string_interner.h"
+#include "bulk_memory.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   define STRING_INTERNER_X64 1
+#   include <emmintrin.h>
+#else
+#   define STRING_INTERNER_X64 0
+#endif
+
+static uint32_t
+finalize_hash(uint64_t hash)
+{
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return (uint32_t)hash;
+
+}
+
+#if STRING_INTERNER_X64
+
+// One 16 byte block: mix the data with the key for this position, multiply the 32-bit
+// halves of each 64-bit lane together and add the result and the (half-swapped) data
+// into the accumulator. The key changes with every block, so reordering blocks changes
+// the hash. SSE2 is part of x86-64, so there is nothing to dispatch on.
+static inline __m128i
+hash_block(__m128i accumulator, __m128i data, __m128i key)
+{
+
+    __m128i keyed = _mm_xor_si128(data, key);
+    __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm_add_epi64(accumulator, _mm_add_epi64(product, swapped));
+
+}
+
+uint32_t
+string_interner_hash(const char *string, size_t length)
+{
+
+    const __m128i step = _mm_set_epi64x((int64_t)0x9E3779B97F4A7C15ULL,
+            (int64_t)0xD6E8FEB86659FD93ULL);
+    __m128i key = _mm_set_epi64x((int64_t)0xC2B2AE3D27D4EB4FULL, (int64_t)0x27D4EB2F165667C5ULL);
+    __m128i accumulator = _mm_set_epi64x((int64_t)0x165667B19E3779F9ULL,
+            (int64_t)(length * 0x9E3779B185EBCA87ULL));
+
+    if (length >= 16)
+    {
+        // Whole blocks, then one more that ends at the last byte and overlaps the one
+        // before it, rather than a ragged tail.
+        const char* cursor = string;
+        const char* end = string + length;
+        for (; cursor + 16 <= end; cursor += 16)
+        {
+            accumulator = hash_block(accumulator, _mm_loadu_si128((const __m128i*)cursor), key);
+            key = _mm_add_epi64(key, step);
+        }
+        if (cursor < end)
+            accumulator = hash_block(accumulator, _mm_loadu_si128((const __m128i*)(end - 16)), key);
+    }
+    else
+    {
+        // Reading 16 bytes from a shorter string could run off the end of a page.
+        alignas(16) char block[16] = {};
+        memcpy(block, string, length);
+        accumulator = hash_block(accumulator, _mm_load_si128((const __m128i*)block), key);
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, accumulator);
+    return finalize_hash(lanes[0] ^ ((lanes[1] << 29) | (lanes[1] >> 35)));
+
+}
+
+static bool
+strings_equal(const char *a, const char *b, size_t length)
+{
+
+    if (length < 16)
+        return memcmp(a, b, length) == 0;
+
+    size_t offset = 0;
+    for (; offset + 16 <= length; offset += 16)
+    {
+        __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + offset)),
+                _mm_loadu_si128((const __m128i*)(b + offset)));
+        if (_mm_movemask_epi8(equal) != 0xFFFF)
+            return false;
+    }
+
+    if (offset < length)
+    {
+        __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + length - 16)),
+                _mm_loadu_si128((const __m128i*)(b + length - 16)));
+        return _mm_movemask_epi8(equal) == 0xFFFF;
+    }
+
+    return true;
+
+}
+
+#else
+
+// FNV-1a everywhere else.
+uint32_t
+string_interner_hash(const char *string, size_t length)
+{
+
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)string[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return finalize_hash(hash);
+
+}
+
+static bool
+strings_equal(const char *a, const char *b, size_t length)
+{
+    return memcmp(a, b, length) == 0;
+}
+
+#endif
+
+// Returns the slot holding the string, or the empty slot where it would go.
+static uint32_t
+find_slot(const string_interner_t *interner, uint32_t hash, const char *string, size_t length,
+        bool *found)
+{
+
+    uint32_t index = hash & interner->table_mask;
+    for (;;)
+    {
+        string_interner_slot_t slot = interner->table[index];
+        if (slot.handle == INTERNED_STRING_NONE)
+        {
+            *found = false;
+            return index;
+        }
+
+        if (slot.hash == hash && string_interner_length(interner, slot.handle) == length
+                && strings_equal(string_interner_get(interner, slot.handle), string, length))
+        {
+            *found = true;
+            return index;
+        }
+
+        index = (index + 1) & interner->table_mask;
+    }
+
+}
+
+// The table gets a fresh arena of its own every time it grows; slots remember their
+// hash, so moving them over never touches the strings. Nothing is committed up front,
+// so the zeroed push hands back fresh pages without clearing them.
+static bool
+grow_table(string_interner_t *interner, size_t slot_count)
+{
+
+    if (slot_count > ((size_t)1 << 32))
+        return false;
+
+    size_t table_size = slot_count * sizeof(string_interner_slot_t);
+    memory_arena_t table_arena;
+    if (!reserve_arena(&table_arena, table_size, 0))
+        return false;
+
+    string_interner_slot_t* table = (string_interner_slot_t*)arena_push_zeroed(&table_arena,
+            table_size, 64);
+    if (table == NULL)
+    {
+        release_arena(&table_arena);
+        return false;
+    }
+
+    uint32_t table_mask = (uint32_t)(slot_count - 1);
+
+    if (interner->table != NULL)
+    {
+        for (size_t i = 0; i <= interner->table_mask; i++)
+        {
+            string_interner_slot_t slot = interner->table[i];
+            if (slot.handle == INTERNED_STRING_NONE)
+                continue;
+
+            uint32_t index = slot.hash & table_mask;
+            while (table[index].handle != INTERNED_STRING_NONE)
+                index = (index + 1) & table_mask;
+            table[index] = slot;
+        }
+
+        release_arena(&interner->table_arena);
+    }
+
+    interner->table_arena = table_arena;
+    interner->table = table;
+    interner->table_mask = table_mask;
+    return true;
+
+}
+
+bool
+allocate_string_interner(string_interner_t *interner, size_t string_reserve, size_t initial_count)
+{
+
+    interner->table = NULL;
+    interner->table_mask = 0;
+    interner->count = 0;
+
+    if (!reserve_arena(&interner->strings, string_reserve))
+        return false;
+
+    size_t slot_count = 16;
+    while (slot_count * 3 < initial_count * 4)
+        slot_count <<= 1;
+
+    if (!grow_table(interner, slot_count))
+    {
+        release_arena(&interner->strings);
+        return false;
+    }
+
+    return true;
+
+}
+
+void
+release_string_interner(string_interner_t *interner)
+{
+
+    release_arena(&interner->strings);
+    if (interner->table != NULL)
+        release_arena(&interner->table_arena);
+
+    interner->table = NULL;
+    interner->count = 0;
+
+}
+
+interned_string
+string_interner_find(const string_interner_t *interner, const char *string, size_t length)
+{
+
+    bool found = false;
+    uint32_t index = find_slot(interner, string_interner_hash(string, length), string, length,
+            &found);
+    return found ? interner->table[index].handle : INTERNED_STRING_NONE;
+
+}
+
+interned_string
+string_intern(string_interner_t *interner, const char *string, size_t length)
+{
+
+    if (length > UINT32_MAX)
+        return INTERNED_STRING_NONE;
+
+    uint32_t hash = string_interner_hash(string, length);
+    bool found = false;
+    uint32_t index = find_slot(interner, hash, string, length, &found);
+    if (found)
+        return interner->table[index].handle;
+
+    // Keep the table at most three quarters full so probe runs stay short.
+    size_t slot_count = (size_t)interner->table_mask + 1;
+    if (((size_t)interner->count + 1) * 4 > slot_count * 3)
+    {
+        if (!grow_table(interner, slot_count * 2))
+            return INTERNED_STRING_NONE;
+        index = find_slot(interner, hash, string, length, &found);
+    }
+
+    // Handles are the record's offset in 32-bit units, so check that the next record
+    // still has one before pushing it.
+    size_t units = (interner->strings.commit + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    if (units >= UINT32_MAX)
+        return INTERNED_STRING_NONE;
+
+    uint32_t* record = (uint32_t*)arena_push_aligned(&interner->strings,
+            sizeof(uint32_t) + length + 1, sizeof(uint32_t));
+    if (record == NULL)
+        return INTERNED_STRING_NONE;
+    assert(record == (uint32_t*)interner->strings.memory_region + units);
+
+    *record = (uint32_t)length;
+    memcpy(record + 1, string, length);
+    ((char*)(record + 1))[length] = '\0';
+
+    interned_string handle = (interned_string)(units + 1);
+    interner->table[index].hash = hash;
+    interner->table[index].handle = handle;
+    interner->count++;
+    return handle;
+
+}
@@ -0,0 +1,86 @@
+#ifndef CUSTOM_ALLOCATORS_STRING_INTERNER_H
+#define CUSTOM_ALLOCATORS_STRING_INTERNER_H
+#include <cstdint>
+#include <cstring>
+#include "custom_memory.h"
+
+// Interns strings: every distinct string is stored once, and identical strings get the
+// same 32-bit handle, so they can be compared and hashed as integers from then on.
+//
+// The strings themselves are packed back to back in a reserved arena, each one behind
+// its length and followed by a terminator, so a handle can be turned back into a C
+// string. Handles are offsets into that arena and stay valid until the interner is
+// released; nothing is ever removed.
+//
+// The table is open addressing with linear probing over 8 byte slots holding the full
+// 32-bit hash and the handle, so a cache line covers eight slots and a lookup usually
+// touches one line of the table plus the string it finds. Hashing and comparison work
+// 16 bytes at a time with SSE2 on x86-64. Lookups never allocate; interning a new
+// string pushes it onto the arena and, now and then, grows the table.
+
+#ifndef STRING_INTERNER_DEFAULT_RESERVE
+#   define STRING_INTERNER_DEFAULT_RESERVE (1024ULL * 1024 * 1024)
+#endif
+
+typedef uint32_t interned_string;
+#define INTERNED_STRING_NONE ((interned_string)0)
+
+struct string_interner_slot_t
+{
+    uint32_t hash;
+    interned_string handle;     // INTERNED_STRING_NONE if the slot is empty.
+};
+
+struct string_interner_t
+{
+    memory_arena_t strings;
+    memory_arena_t table_arena;
+    string_interner_slot_t* table;
+    uint32_t table_mask;
+    uint32_t count;
+};
+
+// The string reservation is address space only and caps the total bytes interned;
+// handles can address up to 16GB of it. The table starts with at least initial_count
+// slots and doubles whenever it gets three quarters full.
+bool   allocate_string_interner(string_interner_t *interner,
+            size_t string_reserve = STRING_INTERNER_DEFAULT_RESERVE, size_t initial_count = 1024);
+void   release_string_interner(string_interner_t *interner);
+
+// Returns the handle for the string, adding it if it isn't already there. Returns
+// INTERNED_STRING_NONE if the string arena is full.
+interned_string string_intern(string_interner_t *interner, const char *string, size_t length);
+
+// Returns the handle for the string if it has been interned, INTERNED_STRING_NONE if not.
+interned_string string_interner_find(const string_interner_t *interner, const char *string,
+            size_t length);
+
+uint32_t string_interner_hash(const char *string, size_t length);
+
+inline interned_string
+string_intern(string_interner_t *interner, const char *string)
+{
+    return string_intern(interner, string, strlen(string));
+}
+
+// Each string is stored as a 32-bit length, the bytes and a terminator, 4 byte aligned;
+// the handle is the offset of the length in 4 byte units, plus one so zero stays free.
+inline const uint32_t*
+string_interner_record(const string_interner_t *interner, interned_string handle)
+{
+    return (const uint32_t*)interner->strings.memory_region + (handle - 1);
+}
+
+inline const char*
+string_interner_get(const string_interner_t *interner, interned_string handle)
+{
+    return (const char*)(string_interner_record(interner, handle) + 1);
+}
+
+inline size_t
+string_interner_length(const string_interner_t *interner, interned_string handle)
+{
+    return *string_interner_record(interner, handle);
+}
+
+#endif
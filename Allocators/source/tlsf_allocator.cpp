@@ -0,0 +1,333 @@
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+#include "tlsf_allocator.h"
+
+#define TLSF_BLOCK_FREE ((size_t)1)
+
+// Index of the highest and lowest set bit. Neither is called with zero.
+static inline int
+tlsf_fls(size_t value)
+{
+#   if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, (unsigned long long)value);
+        return (int)index;
+#   else
+        return 63 - __builtin_clzll((unsigned long long)value);
+#   endif
+}
+
+static inline int
+tlsf_ffs(uint32_t value)
+{
+#   if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return (int)index;
+#   else
+        return __builtin_ctz(value);
+#   endif
+}
+
+static inline size_t
+tlsf_get_size(tlsf_block_t *block)
+{
+    return block->size & ~TLSF_BLOCK_FREE;
+}
+
+static inline bool
+tlsf_is_free(tlsf_block_t *block)
+{
+    return (block->size & TLSF_BLOCK_FREE) != 0;
+}
+
+static inline tlsf_block_t*
+tlsf_next_physical(tlsf_block_t *block)
+{
+    return (tlsf_block_t*)(((char*)block) + TLSF_BLOCK_OVERHEAD + tlsf_get_size(block));
+}
+
+static inline tlsf_block_t*
+tlsf_first_block(tlsf_pool_t *pool)
+{
+    return (tlsf_block_t*)(((char*)pool) + sizeof(tlsf_pool_t));
+}
+
+// Maps a block size to the list it is filed under.
+static inline void
+tlsf_mapping_insert(size_t size, int *fl, int *sl)
+{
+
+    if (size < TLSF_SMALL_BLOCK_SIZE)
+    {
+        // Small sizes all share the first list row, split linearly.
+        *fl = 0;
+        *sl = (int)(size >> TLSF_ALIGN_SIZE_LOG2);
+    }
+    else
+    {
+        int bit = tlsf_fls(size);
+        *sl = (int)(size >> (bit - TLSF_SL_INDEX_COUNT_LOG2)) ^ TLSF_SL_INDEX_COUNT;
+        *fl = bit - (TLSF_FL_INDEX_SHIFT - 1);
+    }
+
+}
+
+// Maps a request to the first list whose blocks are all big enough for it, so the head
+// of any non-empty list at or above it can be used without looking further.
+static inline void
+tlsf_mapping_search(size_t size, int *fl, int *sl)
+{
+
+    if (size >= TLSF_SMALL_BLOCK_SIZE)
+        size += ((size_t)1 << (tlsf_fls(size) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    tlsf_mapping_insert(size, fl, sl);
+
+}
+
+static tlsf_block_t*
+tlsf_find_suitable_block(tlsf_allocator_t *allocator, int *fl, int *sl)
+{
+
+    uint32_t sl_map = allocator->sl_bitmap[*fl] & (~0u << *sl);
+    if (sl_map == 0)
+    {
+        uint32_t fl_map = (*fl + 1 < 32) ? allocator->fl_bitmap & (~0u << (*fl + 1)) : 0;
+        if (fl_map == 0)
+            return NULL;
+
+        *fl = tlsf_ffs(fl_map);
+        sl_map = allocator->sl_bitmap[*fl];
+    }
+
+    *sl = tlsf_ffs(sl_map);
+    return allocator->free_lists[*fl][*sl];
+
+}
+
+static void
+tlsf_insert_free_block(tlsf_allocator_t *allocator, tlsf_block_t *block)
+{
+
+    int fl, sl;
+    tlsf_mapping_insert(tlsf_get_size(block), &fl, &sl);
+
+    tlsf_block_t* head = allocator->free_lists[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL)
+        head->prev_free = block;
+
+    allocator->free_lists[fl][sl] = block;
+    allocator->fl_bitmap |= (1u << fl);
+    allocator->sl_bitmap[fl] |= (1u << sl);
+
+}
+
+static void
+tlsf_remove_free_block(tlsf_allocator_t *allocator, tlsf_block_t *block)
+{
+
+    int fl, sl;
+    tlsf_mapping_insert(tlsf_get_size(block), &fl, &sl);
+
+    if (block->next_free != NULL)
+        block->next_free->prev_free = block->prev_free;
+    if (block->prev_free != NULL)
+        block->prev_free->next_free = block->next_free;
+
+    if (allocator->free_lists[fl][sl] == block)
+    {
+        allocator->free_lists[fl][sl] = block->next_free;
+        if (block->next_free == NULL)
+        {
+            allocator->sl_bitmap[fl] &= ~(1u << sl);
+            if (allocator->sl_bitmap[fl] == 0)
+                allocator->fl_bitmap &= ~(1u << fl);
+        }
+    }
+
+}
+
+bool
+tlsf_initialize(tlsf_allocator_t *allocator, memory_arena_t *arena, size_t initial_size,
+        size_t grow_size)
+{
+
+    *allocator = {};
+    allocator->arena = arena;
+    allocator->grow_size = grow_size;
+
+    if (initial_size > 0)
+        return tlsf_add_pool(allocator, initial_size);
+    return true;
+
+}
+
+bool
+tlsf_add_pool(tlsf_allocator_t *allocator, size_t size)
+{
+
+    // A pool is its header, one free block spanning the rest, and a zero-sized block at
+    // the very end that is never free, so merging never walks off either end.
+    size = size & ~((size_t)TLSF_ALIGN_SIZE - 1);
+    size_t pool_overhead = sizeof(tlsf_pool_t) + 2 * TLSF_BLOCK_OVERHEAD;
+    if (size < pool_overhead + TLSF_BLOCK_SIZE_MIN)
+        return false;
+
+    size_t block_size = size - pool_overhead;
+    if (block_size >= TLSF_BLOCK_SIZE_MAX)
+        return false;
+
+    tlsf_pool_t* pool = (tlsf_pool_t*)arena_push_aligned(allocator->arena, size, TLSF_ALIGN_SIZE);
+    if (pool == NULL)
+        return false;
+
+    pool->size = size;
+    pool->next = allocator->pools;
+    allocator->pools = pool;
+    allocator->pool_bytes += size;
+
+    tlsf_block_t* block = tlsf_first_block(pool);
+    block->prev_physical = NULL;
+    block->size = block_size | TLSF_BLOCK_FREE;
+
+    tlsf_block_t* sentinel = tlsf_next_physical(block);
+    sentinel->prev_physical = block;
+    sentinel->size = 0;
+
+    tlsf_insert_free_block(allocator, block);
+    return true;
+
+}
+
+void*
+tlsf_alloc(tlsf_allocator_t *allocator, size_t size)
+{
+
+    if (size >= TLSF_BLOCK_SIZE_MAX)
+        return NULL;
+    if (size < TLSF_BLOCK_SIZE_MIN)
+        size = TLSF_BLOCK_SIZE_MIN;
+    size = (size + TLSF_ALIGN_SIZE - 1) & ~((size_t)TLSF_ALIGN_SIZE - 1);
+
+    int fl, sl;
+    tlsf_mapping_search(size, &fl, &sl);
+    if (fl >= TLSF_FL_INDEX_COUNT)
+        return NULL;
+
+    tlsf_block_t* block = tlsf_find_suitable_block(allocator, &fl, &sl);
+    if (block == NULL && allocator->grow_size > 0)
+    {
+        // Out of room; take another pool off the arena, big enough to satisfy the search
+        // rounding as well as the request itself.
+        size_t pool_size = size + (size >> TLSF_SL_INDEX_COUNT_LOG2) + TLSF_SMALL_BLOCK_SIZE;
+        if (pool_size < allocator->grow_size)
+            pool_size = allocator->grow_size;
+
+        if (tlsf_add_pool(allocator, pool_size))
+        {
+            tlsf_mapping_search(size, &fl, &sl);
+            block = tlsf_find_suitable_block(allocator, &fl, &sl);
+        }
+    }
+
+    if (block == NULL)
+        return NULL;
+
+    tlsf_remove_free_block(allocator, block);
+
+    // Give back whatever is left over if it is big enough to be a block of its own.
+    size_t block_size = tlsf_get_size(block);
+    if (block_size >= size + sizeof(tlsf_block_t))
+    {
+        tlsf_block_t* remaining = (tlsf_block_t*)(((char*)block) + TLSF_BLOCK_OVERHEAD + size);
+        remaining->prev_physical = block;
+        remaining->size = (block_size - size - TLSF_BLOCK_OVERHEAD) | TLSF_BLOCK_FREE;
+        tlsf_next_physical(remaining)->prev_physical = remaining;
+        tlsf_insert_free_block(allocator, remaining);
+        block_size = size;
+    }
+
+    block->size = block_size;
+    allocator->used_bytes += block_size;
+    allocator->allocation_count++;
+
+    return ((char*)block) + TLSF_BLOCK_OVERHEAD;
+
+}
+
+void
+tlsf_free(tlsf_allocator_t *allocator, void *pointer)
+{
+
+    if (pointer == NULL)
+        return;
+
+    tlsf_block_t* block = (tlsf_block_t*)(((char*)pointer) - TLSF_BLOCK_OVERHEAD);
+    assert(!tlsf_is_free(block));
+
+    allocator->used_bytes -= tlsf_get_size(block);
+    allocator->allocation_count--;
+
+    tlsf_block_t* previous = block->prev_physical;
+    if (previous != NULL && tlsf_is_free(previous))
+    {
+        tlsf_remove_free_block(allocator, previous);
+        previous->size += TLSF_BLOCK_OVERHEAD + tlsf_get_size(block);
+        block = previous;
+    }
+
+    tlsf_block_t* next = tlsf_next_physical(block);
+    if (tlsf_is_free(next))
+    {
+        tlsf_remove_free_block(allocator, next);
+        block->size += TLSF_BLOCK_OVERHEAD + tlsf_get_size(next);
+    }
+
+    block->size |= TLSF_BLOCK_FREE;
+    tlsf_next_physical(block)->prev_physical = block;
+    tlsf_insert_free_block(allocator, block);
+
+}
+
+size_t
+tlsf_block_size(void *pointer)
+{
+    tlsf_block_t* block = (tlsf_block_t*)(((char*)pointer) - TLSF_BLOCK_OVERHEAD);
+    return tlsf_get_size(block);
+}
+
+void
+tlsf_get_statistics(tlsf_allocator_t *allocator, tlsf_statistics_t *statistics)
+{
+
+    *statistics = {};
+    statistics->pool_bytes = allocator->pool_bytes;
+    statistics->used_bytes = allocator->used_bytes;
+    statistics->allocation_count = allocator->allocation_count;
+
+    for (tlsf_pool_t* pool = allocator->pools; pool != NULL; pool = pool->next)
+    {
+        statistics->pool_count++;
+        for (tlsf_block_t* block = tlsf_first_block(pool); tlsf_get_size(block) != 0;
+                block = tlsf_next_physical(block))
+        {
+            if (!tlsf_is_free(block))
+                continue;
+
+            size_t block_size = tlsf_get_size(block);
+            statistics->free_block_count++;
+            statistics->free_bytes += block_size;
+            if (block_size > statistics->largest_free_block)
+                statistics->largest_free_block = block_size;
+        }
+    }
+
+    if (statistics->free_bytes > 0)
+        statistics->fragmentation = 1.0 - (double)statistics->largest_free_block /
+            (double)statistics->free_bytes;
+
+}
+
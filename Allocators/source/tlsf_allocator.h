@@ -0,0 +1,88 @@
+#ifndef CUSTOM_ALLOCATORS_TLSF_ALLOCATOR_H
+#define CUSTOM_ALLOCATORS_TLSF_ALLOCATOR_H
+#include <cstdint>
+#include "custom_memory.h"
+
+// A Two-Level Segregated Fit allocator: a general purpose allocator (any size, freed in
+// any order) whose allocate and free are both O(1), which is what you want on paths that
+// care about the worst case more than the average. It never calls malloc; its memory is
+// pushed off a memory_arena_t in large pools.
+//
+// Free blocks are kept in a two level table of lists. The first level splits sizes by
+// powers of two, the second splits each power of two into TLSF_SL_INDEX_COUNT linear
+// steps, and a bitmap per level lets us find the first non-empty list at or above a
+// size with a couple of bit scans instead of a search. Freed blocks are merged with
+// their free physical neighbours immediately, so the only fragmentation is what the
+// allocation pattern itself leaves behind.
+//
+// Every block carries a 16 byte header and every allocation is 16 byte aligned.
+
+#define TLSF_ALIGN_SIZE_LOG2    4
+#define TLSF_ALIGN_SIZE         (1 << TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_SL_INDEX_COUNT_LOG2 5
+#define TLSF_SL_INDEX_COUNT     (1 << TLSF_SL_INDEX_COUNT_LOG2)
+#define TLSF_FL_INDEX_MAX       38
+#define TLSF_FL_INDEX_SHIFT     (TLSF_SL_INDEX_COUNT_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_FL_INDEX_COUNT     (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+#define TLSF_SMALL_BLOCK_SIZE   (1 << TLSF_FL_INDEX_SHIFT)
+
+// The size field's low bits are always zero, so the lowest one doubles as the free flag.
+// next_free and prev_free only exist while the block is free; once allocated, that is
+// where the caller's data starts.
+struct tlsf_block_t
+{
+    tlsf_block_t* prev_physical;
+    size_t size;
+    tlsf_block_t* next_free;
+    tlsf_block_t* prev_free;
+};
+
+#define TLSF_BLOCK_OVERHEAD     (offsetof(tlsf_block_t, next_free))
+#define TLSF_BLOCK_SIZE_MIN     (sizeof(tlsf_block_t) - TLSF_BLOCK_OVERHEAD)
+#define TLSF_BLOCK_SIZE_MAX     ((size_t)1 << TLSF_FL_INDEX_MAX)
+
+struct tlsf_pool_t
+{
+    tlsf_pool_t* next;
+    size_t size;
+};
+
+struct tlsf_allocator_t
+{
+    memory_arena_t* arena;
+    size_t grow_size;           // Zero means the allocator never takes more from the arena.
+
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[TLSF_FL_INDEX_COUNT];
+    tlsf_block_t* free_lists[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+
+    tlsf_pool_t* pools;
+    size_t pool_bytes;
+    size_t used_bytes;
+    size_t allocation_count;
+};
+
+// Walks every pool, so it is for reporting rather than for hot paths. Fragmentation is
+// the share of free memory that is not in the largest free block; zero means all of
+// the free memory could be handed out by a single allocation.
+struct tlsf_statistics_t
+{
+    size_t pool_count;
+    size_t pool_bytes;
+    size_t used_bytes;
+    size_t free_bytes;
+    size_t allocation_count;
+    size_t free_block_count;
+    size_t largest_free_block;
+    double fragmentation;
+};
+
+bool   tlsf_initialize(tlsf_allocator_t *allocator, memory_arena_t *arena, size_t initial_size,
+            size_t grow_size = 0);
+bool   tlsf_add_pool(tlsf_allocator_t *allocator, size_t size);
+void*  tlsf_alloc(tlsf_allocator_t *allocator, size_t size);
+void   tlsf_free(tlsf_allocator_t *allocator, void *pointer);
+size_t tlsf_block_size(void *pointer);
+void   tlsf_get_statistics(tlsf_allocator_t *allocator, tlsf_statistics_t *statistics);
+
+#endif
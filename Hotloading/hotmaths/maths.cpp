@@ -1,9 +1,14 @@
 #include <maths.h>
 
-HOTMATHS_API_EXPORTS
-DEFINE_PERFORM_OPERATION(perform_operation)
+HOTMATHS_API_EXPORTS int
+perform_operation(int a, int b)
 {
     int result = a * b;
     return result;
 }
 
+HOTMATHS_API_EXPORTS const char*
+get_operation_name()
+{
+    return "multiply";
+}
@@ -1,5 +1,6 @@
 #ifndef HOTMATHS_MATHS_H
 #define HOTMATHS_MATHS_H
+#include <library_api.h>
 
 #if defined( _WIN32 )
 #   define HOTMATHS_API_EXPORTS extern "C" __declspec( dllexport )
@@ -7,27 +8,18 @@
 #   define HOTMATHS_API_EXPORTS extern "C"
 #endif
 
-// Library definitions.
-#define DEFINE_PERFORM_OPERATION(name) int name(int a, int b)
-typedef DEFINE_PERFORM_OPERATION((*hotmath_perform_operation_fptr));
-hotmath_perform_operation_fptr hotmath_perform_operation;
+// Library definitions. Every entry point is listed once here; add a line to export
+// another one and the loader picks it up.
+#define HOTMATHS_API(X) \
+    X(int, perform_operation, (int a, int b)) \
+    X(const char*, get_operation_name, ())
 
-// Loader utilities.
-typedef void* (*hotmaths_proc_loader)(void* handle, const char* fname);
+// The library's own declarations, so its definitions are checked against the list.
+#define HOTMATHS_DECLARE_EXPORT(return_type, name, parameters) \
+    HOTMATHS_API_EXPORTS return_type name parameters;
+HOTMATHS_API(HOTMATHS_DECLARE_EXPORT)
 
-// Loader definition.
-bool
-init_hotmaths_library(void* handle, hotmaths_proc_loader get_proc)
-{
-
-    if (!handle)
-        return false;
-
-    if (!(hotmath_perform_operation = (hotmath_perform_operation_fptr)
-                get_proc(handle, "perform_operation"))) return false;
-
-    return true;
-
-}
+// The loader's side: hotmaths_api_t, hotmaths_api_symbols and resolve_hotmaths_api.
+DECLARE_LIBRARY_API(hotmaths_api, HOTMATHS_API)
 
 #endif
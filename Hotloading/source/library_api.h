@@ -0,0 +1,119 @@
+#ifndef LIBRARY_API_H
+#define LIBRARY_API_H
+#include <cstddef>
+#include <cstdio>
+
+// A library's API is declared once, as a list macro that applies X to every entry
+// point with its return type, name and parameter list:
+//
+//     #define MYLIB_API(X) X(int, add, (int a, int b)) X(void, reset, ())
+//
+//     DECLARE_LIBRARY_API(mylib_api, MYLIB_API)
+//
+// From that one list we get a struct of function pointers named after the entries
+// (mylib_api_t), the table of symbol names (mylib_api_symbols), and a resolver
+// (resolve_mylib_api) that looks every symbol up in one pass. The resolver fills a
+// report with every symbol it couldn't find rather than stopping at the first. Real
+// lists are usually spread over several lines with backslashes, as in maths.h.
+//
+// Callers go through the struct, which packs every pointer next to each other, so a
+// library with hundreds of entry points still swaps in one step (see
+// library_reloader_t) and the pointers a hot loop uses share a few cache lines.
+//
+// The library includes the same header and declares its exports from the list too, so
+// the compiler checks each definition against the declared signature.
+
+// Loader utilities.
+typedef void* (*library_proc_loader)(void* handle, const char* proc_name);
+
+#ifndef LIBRARY_API_MAX_REPORTED
+#   define LIBRARY_API_MAX_REPORTED 16
+#endif
+
+// What a resolver couldn't find. Names point into the static symbol table. If the
+// library couldn't be loaded at all, no symbols were looked up; load_failed is set and
+// load_error says why (from dlerror() or GetLastError() where the OS told us).
+struct library_api_report_t
+{
+    size_t symbol_count;
+    size_t missing_count;
+    const char* missing[LIBRARY_API_MAX_REPORTED];
+
+    bool load_failed;
+    char load_error[256];
+};
+
+inline void
+set_library_load_error(library_api_report_t* report, const char* error)
+{
+    if (report == NULL)
+        return;
+    report->load_failed = true;
+    snprintf(report->load_error, sizeof(report->load_error), "%s", error);
+}
+
+// Looks up every symbol into the matching slot of the table, which is laid out as one
+// pointer per symbol. Returns true only if every symbol was found.
+inline bool
+resolve_library_api(void* handle, library_proc_loader get_proc, const char* const* symbols,
+        size_t symbol_count, void** table, library_api_report_t* report)
+{
+
+    if (report != NULL)
+    {
+        report->symbol_count = symbol_count;
+        report->missing_count = 0;
+        report->load_failed = false;
+        report->load_error[0] = '\0';
+    }
+
+    if (!handle)
+    {
+        set_library_load_error(report, "the library isn't loaded");
+        return false;
+    }
+
+    size_t missing_count = 0;
+    for (size_t index = 0; index < symbol_count; index++)
+    {
+        table[index] = get_proc(handle, symbols[index]);
+        if (table[index] != NULL)
+            continue;
+
+        if (report != NULL && missing_count < LIBRARY_API_MAX_REPORTED)
+            report->missing[missing_count] = symbols[index];
+        missing_count++;
+    }
+
+    if (report != NULL)
+        report->missing_count = missing_count;
+    return missing_count == 0;
+
+}
+
+#define LIBRARY_API_POINTER(return_type, name, parameters) return_type (*name) parameters;
+#define LIBRARY_API_SYMBOL(return_type, name, parameters) #name,
+#define LIBRARY_API_COUNT(return_type, name, parameters) + 1
+
+// Resolving writes data pointers into the struct, which assumes function pointers and
+// data pointers are the same size, as they are on every platform we load libraries on.
+#define DECLARE_LIBRARY_API(api_name, list) \
+    struct api_name##_t \
+    { \
+        list(LIBRARY_API_POINTER) \
+    }; \
+    \
+    inline constexpr const char* api_name##_symbols[] = { list(LIBRARY_API_SYMBOL) }; \
+    inline constexpr size_t api_name##_symbol_count = 0 list(LIBRARY_API_COUNT); \
+    static_assert(sizeof(api_name##_t) == api_name##_symbol_count * sizeof(void*), \
+            "Every entry in the API table must be exactly one pointer."); \
+    \
+    inline bool \
+    resolve_##api_name(void* handle, library_proc_loader get_proc, void* table, \
+            library_api_report_t* report) \
+    { \
+        return resolve_library_api(handle, get_proc, api_name##_symbols, \
+                api_name##_symbol_count, (void**)table, report); \
+    }
+
+#endif
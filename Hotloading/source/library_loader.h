@@ -2,7 +2,18 @@
 #define LIBRARY_LOADER_H
 #include <filesystem>
 #include <string>
+#include <system_error>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "library_api.h"
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 
 #if defined(_WIN32)
@@ -14,6 +25,9 @@
 #   include <unistd.h>
 #   include <fcntl.h>
 #   include <sys/stat.h>
+#   include <sys/inotify.h>
+#   include <sys/eventfd.h>
+#   include <poll.h>
 #endif
 
 // The basic control structure which keeps track of the currently loaded dynamic library.
@@ -97,9 +111,11 @@ get_library_file_time(const char* file_path)
         file_time = (size_t)quad_word_cast.QuadPart;
         CloseHandle(file_handle);
 #   elif defined(__linux__)
+        // Use the full nanosecond timestamp; two builds can easily land in the same second.
         struct stat file_attributes = {};
         stat(file_path, &file_attributes);
-        file_time = (size_t)file_attributes.st_mtime;
+        file_time = (size_t)file_attributes.st_mtim.tv_sec * 1000000000
+            + (size_t)file_attributes.st_mtim.tv_nsec;
 #   endif
 
     return file_time;
@@ -117,6 +133,208 @@ is_library_updated(const char* file_path, size_t last)
     return false;
 }
 
+// Polling the file time costs a system call every time around the loop. The watcher
+// instead lets the OS tell a background thread when the library changes (inotify on
+// Linux, a change notification on Windows), and all the loop has to do is check an
+// atomic flag. Since the file is watched through its directory, builds that replace
+// the library with a rename are caught too.
+//
+// A linker writes the library in several goes, and reloading halfway through would
+// load a broken file. The watcher waits until the file has been left alone for the
+// debounce interval before it raises the flag.
+struct library_watcher_t
+{
+    std::atomic<bool> dirty;
+    std::thread thread;
+    std::string directory;
+    std::string file_name;
+    int debounce_ms;
+
+    // Optionally called on the watcher thread each time the flag is raised.
+    void (*on_change)(void* user);
+    void* on_change_user;
+
+#   if defined(_WIN32)
+        HANDLE change_handle;
+        HANDLE stop_event;
+#   elif defined(__linux__)
+        int inotify_descriptor;
+        int stop_descriptor;
+#   endif
+};
+
+// Runs on the watcher thread until stop_library_watcher is called.
+inline void
+library_watcher_thread(library_watcher_t* watcher)
+{
+
+    bool pending = false;
+
+#   if defined(_WIN32)
+        std::string file_path = set_canonical_file_path(watcher->directory, watcher->file_name);
+        WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+        GetFileAttributesExA(file_path.c_str(), GetFileExInfoStandard, &attributes);
+        FILETIME last_write_time = attributes.ftLastWriteTime;
+
+        HANDLE handles[2] = { watcher->stop_event, watcher->change_handle };
+        while (true)
+        {
+            DWORD wait_result = WaitForMultipleObjects(2, handles, FALSE,
+                    pending ? (DWORD)watcher->debounce_ms : INFINITE);
+            if (wait_result == WAIT_OBJECT_0 || wait_result == WAIT_FAILED)
+                break;
+
+            // Something in the directory changed; keep waiting until it settles.
+            if (wait_result == WAIT_OBJECT_0 + 1)
+            {
+                FindNextChangeNotification(watcher->change_handle);
+                pending = true;
+                continue;
+            }
+
+            // The notification doesn't say which file changed, and copying the live
+            // library lands in the same directory, so check our file actually did.
+            pending = false;
+            attributes = {};
+            if (GetFileAttributesExA(file_path.c_str(), GetFileExInfoStandard, &attributes)
+                    && CompareFileTime(&attributes.ftLastWriteTime, &last_write_time) != 0)
+            {
+                last_write_time = attributes.ftLastWriteTime;
+                watcher->dirty.store(true, std::memory_order_release);
+                if (watcher->on_change != NULL)
+                    watcher->on_change(watcher->on_change_user);
+            }
+        }
+#   elif defined(__linux__)
+        alignas(struct inotify_event) char buffer[4096];
+        while (true)
+        {
+            pollfd descriptors[2] = {};
+            descriptors[0].fd = watcher->stop_descriptor;
+            descriptors[0].events = POLLIN;
+            descriptors[1].fd = watcher->inotify_descriptor;
+            descriptors[1].events = POLLIN;
+
+            int poll_result = poll(descriptors, 2, pending ? watcher->debounce_ms : -1);
+            if (poll_result < 0 && errno != EINTR)
+                break;
+            if (descriptors[0].revents != 0)
+                break;
+
+            // Quiet for a whole debounce interval; the file is done.
+            if (poll_result == 0)
+            {
+                pending = false;
+                watcher->dirty.store(true, std::memory_order_release);
+                if (watcher->on_change != NULL)
+                    watcher->on_change(watcher->on_change_user);
+                continue;
+            }
+
+            if (!(descriptors[1].revents & POLLIN))
+                continue;
+
+            ssize_t length = read(watcher->inotify_descriptor, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length; )
+            {
+                struct inotify_event* event = (struct inotify_event*)(buffer + offset);
+                if (event->len != 0 && watcher->file_name == event->name)
+                    pending = true;
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+        }
+#   endif
+
+}
+
+// Starts watching the library at file_path. Returns false if the OS refused, in which
+// case the watcher is left stopped and is_library_updated still works as a fallback.
+inline bool
+start_library_watcher(library_watcher_t* watcher, const char* file_path, int debounce_ms = 100,
+        void (*on_change)(void* user) = NULL, void* on_change_user = NULL)
+{
+
+    assert(watcher != NULL);
+
+    std::filesystem::path path = file_path;
+    watcher->directory = path.parent_path().string();
+    watcher->file_name = path.filename().string();
+    watcher->debounce_ms = debounce_ms;
+    watcher->on_change = on_change;
+    watcher->on_change_user = on_change_user;
+    watcher->dirty.store(false, std::memory_order_relaxed);
+
+#   if defined(_WIN32)
+        watcher->change_handle = FindFirstChangeNotificationA(watcher->directory.c_str(), FALSE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        if (watcher->change_handle == INVALID_HANDLE_VALUE)
+            return false;
+
+        watcher->stop_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+        if (watcher->stop_event == NULL)
+        {
+            FindCloseChangeNotification(watcher->change_handle);
+            return false;
+        }
+#   elif defined(__linux__)
+        watcher->inotify_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watcher->inotify_descriptor < 0)
+            return false;
+
+        // Writes in place, and new files created or renamed over the old one.
+        if (inotify_add_watch(watcher->inotify_descriptor, watcher->directory.c_str(),
+                    IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO) < 0)
+        {
+            close(watcher->inotify_descriptor);
+            return false;
+        }
+
+        watcher->stop_descriptor = eventfd(0, EFD_CLOEXEC);
+        if (watcher->stop_descriptor < 0)
+        {
+            close(watcher->inotify_descriptor);
+            return false;
+        }
+#   endif
+
+    watcher->thread = std::thread(library_watcher_thread, watcher);
+    return true;
+
+}
+
+inline void
+stop_library_watcher(library_watcher_t* watcher)
+{
+
+    if (!watcher->thread.joinable())
+        return;
+
+#   if defined(_WIN32)
+        SetEvent(watcher->stop_event);
+        watcher->thread.join();
+        CloseHandle(watcher->stop_event);
+        FindCloseChangeNotification(watcher->change_handle);
+#   elif defined(__linux__)
+        uint64_t stop = 1;
+        ssize_t written = write(watcher->stop_descriptor, &stop, sizeof(stop));
+        (void)written;
+        watcher->thread.join();
+        close(watcher->stop_descriptor);
+        close(watcher->inotify_descriptor);
+#   endif
+
+}
+
+// Returns true once for each settled change to the library, and clears the flag. When
+// nothing has changed this is a single relaxed load; no system calls, no stores.
+inline bool
+is_library_watcher_dirty(library_watcher_t* watcher)
+{
+    if (!watcher->dirty.load(std::memory_order_relaxed))
+        return false;
+    return watcher->dirty.exchange(false, std::memory_order_acquire);
+}
+
 // This will attempt to load the procedures within the library. We provide
 // this function to the library loader procedure provided in its header file.
 // The library will check if the proc address returned by this function is valid.
@@ -135,6 +353,59 @@ get_library_proc(void* handle, const char* proc_name)
     return proc_address;
 }
 
+// Closes a library handle opened by open_library_copy.
+inline void
+close_library_handle(void* handle)
+{
+#   if defined(_WIN32)
+        FreeLibrary((HMODULE)handle);
+#   elif defined(__linux__)
+        dlclose(handle);
+#   endif
+}
+
+// Copies the library to tmp_path and loads the copy, so the original stays free for the
+// next build to overwrite. Returns NULL if either step fails, and if asked, says why.
+inline void*
+open_library_copy(const char* lib_path, const char* tmp_path, std::string* error = NULL)
+{
+
+    // Check if the library itself exists.
+    if (!std::filesystem::exists(lib_path))
+    {
+        if (error != NULL) *error = std::string("library not found: ") + lib_path;
+        return NULL;
+    }
+
+    // Create a copy of the library. (That is one aggressive namespace!)
+    std::error_code copy_error;
+    if (!std::filesystem::copy_file(lib_path, tmp_path,
+            std::filesystem::copy_options::overwrite_existing, copy_error))
+    {
+        if (error != NULL) *error = "unable to copy the library: " + copy_error.message();
+        return NULL;
+    }
+    
+    // Once the file is copied, we can now load it.
+    void* handle = NULL;
+#   if defined(_WIN32)
+        handle = (void*)LoadLibraryA(tmp_path);
+        if (handle == NULL && error != NULL)
+            *error = "LoadLibrary failed: "
+                + std::system_category().message((int)GetLastError());
+#   elif defined(__linux__)
+        handle = dlopen(tmp_path, RTLD_NOW);
+        if (handle == NULL && error != NULL)
+        {
+            const char* dl_error = dlerror();
+            *error = (dl_error != NULL) ? dl_error : "dlopen failed";
+        }
+#   endif
+
+    return handle;
+
+}
+
 // This function is responsible for loading a library into memory. It first checks
 // if there is a library already loaded and unloads it. This will allow the user
 // to call this function to "hotswap" the shared library if it is already in memory.
@@ -147,30 +418,11 @@ load_library_instance(dynamic_library_t* library, const char* lib_path, const ch
     // Unload the library if it is already loaded.
     if (library->handle != NULL)
     {
-#       if defined(_WIN32)
-            FreeLibrary((HMODULE)library->handle);
-#       elif defined(__linux)
-            dlclose(library->handle);
-#       endif
-
+        close_library_handle(library->handle);
         library->handle = NULL; // Zero out, prevent hanging pointer refs.
-
     }
-       
-    // Check if the library itself exists.
-    if (!std::filesystem::exists(lib_path)) return false;
 
-    // Create a copy of the library. (That is one aggressive namespace!)
-    if (!std::filesystem::copy_file(lib_path, tmp_path,
-            std::filesystem::copy_options::overwrite_existing))
-        return false;
-    
-    // Once the file is copied, we can now load it.
-#   if defined(_WIN32)
-        library->handle = (void*)LoadLibraryA(tmp_path);
-#   elif defined(__linux)
-        library->handle = dlopen(tmp_path, RTLD_NOW);
-#   endif
+    library->handle = open_library_copy(lib_path, tmp_path);
 
     // Ensure the library is loaded.
     if (library->handle == NULL)
@@ -182,4 +434,388 @@ load_library_instance(dynamic_library_t* library, const char* lib_path, const ch
     return true;
 }
 
+// Reloading with load_library_instance stops the calling thread for the whole copy and
+// load, and any other thread still running code from the old library crashes when it is
+// closed underneath it. The reloader does the work on a background thread instead and
+// publishes the library through a table of function pointers:
+//
+//  1. When the watcher reports a change, the reload thread copies the library to a new
+//     file (one per load, since the old copy is still mapped), loads it, and resolves
+//     every symbol into a freshly allocated table. A library missing anything is
+//     rejected and the current one stays in place.
+//  2. The new table is published with a single atomic store. Callers that load the table
+//     from then on get the new library; callers already inside the old one carry on.
+//  3. The old library and table are retired, and closed once every registered reader
+//     thread has passed a quiescent point, a place where it holds no pointer into a
+//     table (the top of its main loop, say). This is the quiescent-state flavor of RCU.
+//
+// Readers never lock or wait. Loading the table is an acquire load, and reporting a
+// quiescent point is a load and a store to the reader's own cache line. A reader that
+// stops reporting holds back reclamation (not reloads) until it unregisters.
+
+#ifndef LIBRARY_RELOADER_MAX_READERS
+#   define LIBRARY_RELOADER_MAX_READERS 64
+#endif
+
+// Fills out a table of function pointers from a loaded library, such as the resolvers
+// DECLARE_LIBRARY_API generates. Returns false if any symbol is missing, and lists them
+// in the report.
+typedef bool (*library_table_resolver)(void* handle, library_proc_loader get_proc, void* table,
+        library_api_report_t* report);
+
+// Each reader gets a cache line of its own so reporting never contends.
+struct alignas(64) library_reader_t
+{
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool> active;
+};
+
+struct library_retired_t
+{
+    void* handle;
+    void* table;
+    std::string path;
+    uint64_t epoch;
+};
+
+struct library_reloader_t
+{
+    std::atomic<void*> table;
+    std::atomic<uint64_t> epoch;
+    std::atomic<uint64_t> reload_count;
+    std::atomic<uint64_t> rejected_count;
+    library_reader_t readers[LIBRARY_RELOADER_MAX_READERS];
+
+    std::string lib_path;
+    std::string tmp_path;
+    size_t table_size;
+    library_table_resolver resolve;
+
+    // Only touched by the reload thread, or under the mutex.
+    void* handle;
+    std::string handle_path;
+    uint64_t generation;
+    std::vector<library_retired_t> retired;
+    library_api_report_t last_report;
+
+    library_watcher_t watcher;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool reload_requested;
+    bool stopping;
+};
+
+// Each load gets its own copy: Hotmaths_live.so becomes Hotmaths_live_1.so and so on.
+inline std::string
+get_library_generation_path(const std::string& tmp_path, uint64_t generation)
+{
+    std::filesystem::path path = tmp_path;
+    std::string file_name = path.stem().string() + "_" + std::to_string(generation)
+        + path.extension().string();
+    return path.replace_filename(file_name).string();
+}
+
+// Tables start on a cache line of their own, so a small API fits in as few lines as
+// possible and never shares one with anything that gets written.
+inline void*
+allocate_library_table(size_t table_size)
+{
+
+    size_t aligned_size = (table_size + 63) & ~(size_t)63;
+    void* table = NULL;
+#   if defined(_WIN32)
+        table = _aligned_malloc(aligned_size, 64);
+#   else
+        table = aligned_alloc(64, aligned_size);
+#   endif
+
+    if (table != NULL)
+        memset(table, 0, aligned_size);
+    return table;
+
+}
+
+inline void
+free_library_table(void* table)
+{
+#   if defined(_WIN32)
+        _aligned_free(table);
+#   else
+        free(table);
+#   endif
+}
+
+// Loads the next generation of the library and resolves a table for it. Runs without
+// the mutex held; the reload thread is the only one that loads.
+inline bool
+load_library_generation(library_reloader_t* reloader, void** handle, void** table,
+        std::string* path, library_api_report_t* report)
+{
+
+    *path = get_library_generation_path(reloader->tmp_path, ++reloader->generation);
+    std::string load_error;
+    *handle = open_library_copy(reloader->lib_path.c_str(), path->c_str(), &load_error);
+    if (*handle == NULL)
+    {
+        set_library_load_error(report, load_error.c_str());
+        std::error_code remove_error;
+        std::filesystem::remove(*path, remove_error);
+        return false;
+    }
+
+    *table = allocate_library_table(reloader->table_size);
+    if (*table == NULL)
+        set_library_load_error(report, "out of memory for the function table");
+    if (*table == NULL || !reloader->resolve(*handle, get_library_proc, *table, report))
+    {
+        free_library_table(*table);
+        close_library_handle(*handle);
+        std::error_code remove_error;
+        std::filesystem::remove(*path, remove_error);
+        return false;
+    }
+
+    return true;
+
+}
+
+// Closes every retired library that no active reader can still be using. Called with
+// the mutex held.
+inline void
+reclaim_retired_libraries(library_reloader_t* reloader)
+{
+
+    uint64_t oldest_epoch = reloader->epoch.load(std::memory_order_acquire);
+    for (library_reader_t& reader : reloader->readers)
+    {
+        if (!reader.active.load(std::memory_order_acquire))
+            continue;
+        uint64_t reader_epoch = reader.epoch.load(std::memory_order_acquire);
+        if (reader_epoch < oldest_epoch)
+            oldest_epoch = reader_epoch;
+    }
+
+    size_t kept = 0;
+    for (library_retired_t& retired : reloader->retired)
+    {
+        if (retired.epoch > oldest_epoch)
+        {
+            reloader->retired[kept++] = retired;
+            continue;
+        }
+
+        close_library_handle(retired.handle);
+        free_library_table(retired.table);
+        std::error_code remove_error;
+        std::filesystem::remove(retired.path, remove_error);
+    }
+    reloader->retired.resize(kept);
+
+}
+
+inline void
+library_reloader_request(void* user)
+{
+    library_reloader_t* reloader = (library_reloader_t*)user;
+    std::lock_guard<std::mutex> lock(reloader->mutex);
+    reloader->reload_requested = true;
+    reloader->wake.notify_one();
+}
+
+inline void
+library_reloader_thread(library_reloader_t* reloader)
+{
+
+    std::unique_lock<std::mutex> lock(reloader->mutex);
+    while (!reloader->stopping)
+    {
+        // Nothing to do until a change comes in, except to check back now and then
+        // while there are retired libraries waiting on readers.
+        if (!reloader->reload_requested)
+        {
+            if (reloader->retired.empty())
+                reloader->wake.wait(lock);
+            else
+                reloader->wake.wait_for(lock, std::chrono::milliseconds(10));
+        }
+
+        if (reloader->stopping)
+            break;
+
+        if (reloader->reload_requested)
+        {
+            reloader->reload_requested = false;
+
+            lock.unlock();
+            void* handle = NULL;
+            void* table = NULL;
+            std::string path;
+            library_api_report_t report = {};
+            bool loaded = load_library_generation(reloader, &handle, &table, &path, &report);
+            lock.lock();
+
+            reloader->last_report = report;
+            if (!loaded)
+                reloader->rejected_count.fetch_add(1, std::memory_order_relaxed);
+
+            if (loaded)
+            {
+                // Publish first, then move the epoch on. A reader that sees the new
+                // epoch at a quiescent point is guaranteed to see the new table after it.
+                void* old_table = reloader->table.exchange(table, std::memory_order_acq_rel);
+                uint64_t retired_epoch = reloader->epoch.fetch_add(1,
+                        std::memory_order_acq_rel) + 1;
+                reloader->retired.push_back({ reloader->handle, old_table,
+                        reloader->handle_path, retired_epoch });
+                reloader->handle = handle;
+                reloader->handle_path = path;
+                reloader->reload_count.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        reclaim_retired_libraries(reloader);
+    }
+
+}
+
+// Loads the library and its table on the calling thread, then starts watching for
+// changes. Returns false if the first load fails; the reloader is left stopped, and
+// the report (if given) lists what was missing.
+inline bool
+start_library_reloader(library_reloader_t* reloader, const char* lib_path, const char* tmp_path,
+        size_t table_size, library_table_resolver resolve, library_api_report_t* report = NULL)
+{
+
+    assert(reloader != NULL && table_size > 0 && resolve != NULL);
+
+    reloader->table.store(NULL, std::memory_order_relaxed);
+    reloader->epoch.store(1, std::memory_order_relaxed);
+    reloader->reload_count.store(0, std::memory_order_relaxed);
+    reloader->rejected_count.store(0, std::memory_order_relaxed);
+    reloader->last_report = {};
+    for (library_reader_t& reader : reloader->readers)
+    {
+        reader.epoch.store(0, std::memory_order_relaxed);
+        reader.active.store(false, std::memory_order_relaxed);
+    }
+
+    reloader->lib_path = lib_path;
+    reloader->tmp_path = tmp_path;
+    reloader->table_size = table_size;
+    reloader->resolve = resolve;
+    reloader->handle = NULL;
+    reloader->generation = 0;
+    reloader->reload_requested = false;
+    reloader->stopping = false;
+
+    void* table = NULL;
+    if (!load_library_generation(reloader, &reloader->handle, &table, &reloader->handle_path,
+                &reloader->last_report))
+    {
+        if (report != NULL)
+            *report = reloader->last_report;
+        return false;
+    }
+    reloader->table.store(table, std::memory_order_release);
+
+    reloader->thread = std::thread(library_reloader_thread, reloader);
+
+    // Without a watcher nothing ever triggers a reload, but what we loaded still works.
+    start_library_watcher(&reloader->watcher, lib_path, 100, library_reloader_request, reloader);
+    return true;
+
+}
+
+// Stops watching and reloading and closes every library. All readers must be done.
+inline void
+stop_library_reloader(library_reloader_t* reloader)
+{
+
+    if (!reloader->thread.joinable())
+        return;
+
+    stop_library_watcher(&reloader->watcher);
+    {
+        std::lock_guard<std::mutex> lock(reloader->mutex);
+        reloader->stopping = true;
+        reloader->wake.notify_one();
+    }
+    reloader->thread.join();
+
+    for (library_retired_t& retired : reloader->retired)
+    {
+        close_library_handle(retired.handle);
+        free_library_table(retired.table);
+        std::error_code remove_error;
+        std::filesystem::remove(retired.path, remove_error);
+    }
+    reloader->retired.clear();
+
+    close_library_handle(reloader->handle);
+    free_library_table(reloader->table.exchange(NULL, std::memory_order_acq_rel));
+    std::error_code remove_error;
+    std::filesystem::remove(reloader->handle_path, remove_error);
+    reloader->handle = NULL;
+
+}
+
+// The result of the most recent load: why the library couldn't be loaded, or which
+// symbols were missing, if any. A load that failed either way is never published;
+// rejected_count counts those.
+inline library_api_report_t
+get_library_reloader_report(library_reloader_t* reloader)
+{
+    std::lock_guard<std::mutex> lock(reloader->mutex);
+    return reloader->last_report;
+}
+
+// Every thread that calls through the table registers once and gets a reader index
+// back, or -1 if all the slots are taken.
+inline int
+register_library_reader(library_reloader_t* reloader)
+{
+
+    std::lock_guard<std::mutex> lock(reloader->mutex);
+    for (int index = 0; index < LIBRARY_RELOADER_MAX_READERS; index++)
+    {
+        library_reader_t& reader = reloader->readers[index];
+        if (reader.active.load(std::memory_order_relaxed))
+            continue;
+
+        reader.epoch.store(reloader->epoch.load(std::memory_order_acquire),
+                std::memory_order_relaxed);
+        reader.active.store(true, std::memory_order_release);
+        return index;
+    }
+
+    return -1;
+
+}
+
+inline void
+unregister_library_reader(library_reloader_t* reloader, int reader)
+{
+    std::lock_guard<std::mutex> lock(reloader->mutex);
+    reloader->readers[reader].active.store(false, std::memory_order_release);
+    reloader->wake.notify_one();
+}
+
+// The current table. Don't hold onto it past the reader's next quiescent point.
+template <typename T> inline T*
+get_library_table(library_reloader_t* reloader)
+{
+    return (T*)reloader->table.load(std::memory_order_acquire);
+}
+
+// Tells the reloader the calling reader holds no pointers into any table right now.
+inline void
+library_reader_quiescent(library_reloader_t* reloader, int reader)
+{
+    uint64_t epoch = reloader->epoch.load(std::memory_order_acquire);
+    library_reader_t& slot = reloader->readers[reader];
+    if (slot.epoch.load(std::memory_order_relaxed) != epoch)
+        slot.epoch.store(epoch, std::memory_order_release);
+}
+
 #endif
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <chrono> // Used for sleeping.
 #include <thread> // Used for sleeping.
+#include <atomic>
+#include <vector>
 
 #include <maths.h>
 #include <library_loader.h>
@@ -12,6 +14,27 @@
 #   define LIBRARY_EXTENSION ".so"
 #endif
 
+// Says why a load was rejected: either the library couldn't be loaded at all, or it
+// was missing some of the symbols the API table needs.
+static void
+print_library_report(const char* message, const library_api_report_t& report)
+{
+
+    std::cout << message;
+    if (report.load_failed)
+    {
+        std::cout << "; " << report.load_error << std::endl;
+        return;
+    }
+
+    std::cout << "; " << report.missing_count << " of " << report.symbol_count
+        << " symbols missing:";
+    for (size_t i = 0; i < report.missing_count && i < LIBRARY_API_MAX_REPORTED; i++)
+        std::cout << " " << report.missing[i];
+    std::cout << std::endl;
+
+}
+
 int
 main(int argc, char** argv)
 {
@@ -33,44 +56,89 @@ main(int argc, char** argv)
         << "Library path: " << hotmath_library.lib_path << std::endl
         << "Temp Library Path: " << hotmath_library.tmp_path << std::endl;
 
-    // Attempt to intialize our library instance. We use c-strings in this situation
-    // because the platform functionality expects c-strings for their parameters.
-    // It should also be noted that although we filled out the paths within the
-    // dynamic_library_t structure and could use them within the function itself, this
-    // may not be entirely apparent to front-end API users; only that when this
-    // function succeeds, the structure contains internal data that manages where that
-    // shared library is stored and the most recent file time.
-    bool load_library_result = load_library_instance(&hotmath_library,
-            hotmath_library.lib_path.c_str(), hotmath_library.tmp_path.c_str());
-    assert(load_library_result == true);
-
-    // Now that the library is loaded, we can now call the library's initialization
-    // procedure as defined in its header file.
-    bool init_library_result = init_hotmaths_library(hotmath_library.handle,
-            get_library_proc);
-    assert(load_library_result == true);
+    // Load the library, then keep reloading it in the background whenever a build
+    // replaces it. Callers reach the library through a table of function pointers that
+    // the reloader swaps out as a whole, so a reload never stalls anybody and never
+    // pulls code out from under a thread that is still running it.
+    library_reloader_t hotmath_reloader;
+    library_api_report_t load_report = {};
+    bool reloader_started = start_library_reloader(&hotmath_reloader,
+            hotmath_library.lib_path.c_str(), hotmath_library.tmp_path.c_str(),
+            sizeof(hotmaths_api_t), resolve_hotmaths_api, &load_report);
+    if (reloader_started == false)
+    {
+        print_library_report("Unable to load the library", load_report);
+        return 1;
+    }
+
+    // A couple of workers call into the library as fast as they can. Each one reports a
+    // quiescent point between calls, which is what lets old libraries get closed.
+    static std::atomic<bool> runtime_flag = true;
+    std::atomic<uint64_t> worker_calls = 0;
+    std::vector<std::thread> workers;
+    for (int worker = 0; worker < 2; worker++)
+    {
+        workers.emplace_back([&]()
+        {
+            int reader = register_library_reader(&hotmath_reloader);
+            assert(reader >= 0);
+
+            uint64_t calls = 0;
+            int sum = 0;
+            while (runtime_flag.load(std::memory_order_relaxed))
+            {
+                hotmaths_api_t* api = get_library_table<hotmaths_api_t>(&hotmath_reloader);
+                sum += api->perform_operation((int)calls, 4);
+                library_reader_quiescent(&hotmath_reloader, reader);
+
+                if ((++calls & 0xFFFF) == 0)
+                    worker_calls.fetch_add(0x10000, std::memory_order_relaxed);
+            }
+
+            unregister_library_reader(&hotmath_reloader, reader);
+            (void)sum;
+        });
+    }
+
+    // The main loop is a reader too.
+    int main_reader = register_library_reader(&hotmath_reloader);
+    assert(main_reader >= 0);
 
     // A simulated "main loop" which does "stuff".
-    static bool runtime_flag = true;
-    while (runtime_flag == true)
+    uint64_t last_calls = 0;
+    uint64_t last_rejected = 0;
+    while (runtime_flag.load(std::memory_order_relaxed))
     {
-        
-        // Check the file time and update accordingly.
-        // If the filetimes change, then we know the library should be reloaded.
-        // Make changes to maths.cpp, compile, and it should update immediately!
-        if (is_library_updated(hotmath_library.lib_path.c_str(), hotmath_library.file_time))
-            load_library_instance(&hotmath_library, hotmath_library.lib_path.c_str(),
-                    hotmath_library.tmp_path.c_str());
-
-        // Perform the operation. This is how you will see the updates.
-        std::cout << "Operation result: "
-            << hotmath_perform_operation(3, 4)
+
+        // Perform the operation. This is how you will see the updates; make changes to
+        // maths.cpp, compile, and it should update immediately!
+        hotmaths_api_t* api = get_library_table<hotmaths_api_t>(&hotmath_reloader);
+        uint64_t calls = worker_calls.load(std::memory_order_relaxed);
+        std::cout << "Operation result (" << api->get_operation_name() << "): "
+            << api->perform_operation(3, 4)
+            << " (reloads: " << hotmath_reloader.reload_count.load(std::memory_order_relaxed)
+            << ", worker calls: " << (calls - last_calls) << ")"
             << std::endl;
+        last_calls = calls;
+        library_reader_quiescent(&hotmath_reloader, main_reader);
+
+        // A build that won't load or dropped an export is never swapped in; say why.
+        uint64_t rejected = hotmath_reloader.rejected_count.load(std::memory_order_relaxed);
+        if (rejected != last_rejected)
+        {
+            print_library_report("Reload rejected",
+                    get_library_reloader_report(&hotmath_reloader));
+            last_rejected = rejected;
+        }
 
         // Sleep to prevent the output from being nuked.
         std::this_thread::sleep_for(std::chrono::milliseconds(250));
     }
 
+    for (std::thread& worker : workers)
+        worker.join();
+    unregister_library_reader(&hotmath_reloader, main_reader);
+    stop_library_reloader(&hotmath_reloader);
     return 0;
 }
 